@@ -0,0 +1,79 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Bump allocator handing out flat, pre-sized regions from large blocks.
+// Memory is only released all at once (reset or destruction), so pointers
+// stay valid until then.
+class Arena {
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+        size_t used;
+    };
+
+    std::vector<Block> blocks;
+    size_t blockSize;  // Default size of newly added blocks
+    size_t used;       // Bytes currently handed out
+    size_t peak;       // High-water mark of used bytes
+    size_t reserved;   // Bytes owned by all blocks
+
+    void *allocateBytes(size_t bytes, size_t alignment);
+
+public:
+    explicit Arena(size_t initialBytes = 1 << 20);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Allocate an uninitialised array of count elements of type T
+    template <typename T>
+    T *allocate(size_t count) {
+        return static_cast<T *>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    // Release every allocation but keep the largest block for reuse
+    void reset();
+
+    // Getters
+    size_t getUsed() const;
+    size_t getPeak() const;
+    size_t getReserved() const;
+};
+
+// Row-major table of doubles living in an arena region sized up front
+class RowBuffer {
+private:
+    double *values;
+    size_t rows;
+    size_t cols;
+    size_t capacity; // Maximum number of rows
+
+public:
+    RowBuffer();
+    RowBuffer(Arena& arena, size_t maxRows, size_t numCols);
+
+    // Append a row of getCols() values; returns false if the region is full
+    bool appendRow(const double *row);
+
+    // Mark rows as filled after writing through data(); clamped to capacity
+    void resize(size_t numRows);
+
+    double *row(size_t i);
+    const double *row(size_t i) const;
+
+    double *data();
+    const double *data() const;
+
+    size_t getRows() const;
+    size_t getCols() const;
+    size_t getCapacity() const;
+    bool empty() const;
+};
+
+#endif // ARENA_H
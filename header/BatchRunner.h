@@ -0,0 +1,22 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <functional>
+
+// Runs many independent in-process jobs (typically one SimulationEngine
+// each) across a fixed number of threads.
+class BatchRunner {
+private:
+    int numThreads;
+
+public:
+    // 0 threads means one per hardware thread
+    explicit BatchRunner(int threads = 0);
+
+    int getNumThreads() const;
+
+    // Call job(i) for every i in [0, numJobs); rethrows the first job exception
+    void run(int numJobs, const std::function<void(int)>& job) const;
+};
+
+#endif // BATCHRUNNER_H
@@ -3,19 +3,39 @@
 
 #include <string>
 #include <vector>
+#include <istream>
 #include "SIRCell.h"
+#include "Arena.h"
+#include "ParameterSchedule.h"
 
 class CSVParser {
 private:
     // Helper function: trim whitespace from a string
     static std::string trim(const std::string &s);
+    
+    // Helper function: count lines of a stream, then rewind it
+    static size_t countLines(std::istream &in);
 
 public:
-    // Parse CSV data
-    static std::vector<std::vector<double>> loadUSStateData(const std::string& filename);
+    // Number of values stored per parsed row
+    static const int ROW_COLUMNS = 6;
+
+    // Parse CSV data into a flat row buffer allocated from the arena
+    static RowBuffer loadUSStateData(const std::string& filename, Arena& arena);
+    
+    // Parse observed time series: a header line, then rows of [time, I_region0, I_region1, ...]
+    static RowBuffer loadObservedSeries(const std::string& filename, Arena& arena);
+    
+    // Parse an intervention file into the schedule. Rows of
+    // Kind,Target,Parameter,When,Value,Mode where Kind is one of
+    //   group: put region Target into group Value
+    //   knot:  schedule point of group Target (* = all) at time When, Mode step|linear
+    //   event: change at step When for group Target (* = all), Mode set|scale|reset
+    // '#' starts a comment; invalid targets or knot modes throw with the line number
+    static void loadInterventions(const std::string& filename, ParameterSchedule& schedule);
     
     // Convert row data to SIR cell
-    static SIRCell mapToSIR(const std::vector<double>& rowData);
+    static SIRCell mapToSIR(const double *rowData);
 };
 
 #endif // CSVPARSER_H
\ No newline at end of file
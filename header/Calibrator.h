@@ -0,0 +1,66 @@
+#ifndef CALIBRATOR_H
+#define CALIBRATOR_H
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include "SIRCell.h"
+#include "SIRModel.h"
+#include "Arena.h"
+#include "BatchRunner.h"
+
+class SimulationEngine;
+
+struct CalibrationResult {
+    double beta;
+    double gamma;
+    double error;     // Sum of squared errors against the observations
+    int iterations;
+    int evaluations;
+};
+
+// Fits beta and gamma to observed infected fractions with Nelder-Mead.
+// Observations are rows of [time, I_region0, I_region1, ...], where region r
+// is cell r of the grid. Every objective evaluation is a full in-process run,
+// and the candidates of one iteration are evaluated in parallel threads. Engines
+// are pooled, so each thread reuses its grid, neighbors and result buffer.
+class Calibrator {
+private:
+    SIRModel baseModel; // Supplies dt and the number of steps
+    std::vector<SIRCell> cells;
+    std::unordered_map<int, std::vector<int>> neighborMap;
+    const BatchRunner& runner;
+
+    // Observations aligned to simulation steps, stored row-major
+    std::vector<int> observedStep;
+    std::vector<double> observedI; // observedStep.size() x numRegions
+    int numRegions;
+    int evaluations;
+
+    // Engine pool: engines cycle between the free list and running evaluations
+    mutable std::vector<std::unique_ptr<SimulationEngine>> engines;
+    mutable std::vector<SimulationEngine *> freeEngines;
+    mutable std::mutex engineMutex;
+
+    SimulationEngine *acquireEngine() const;
+    void releaseEngine(SimulationEngine *engine) const;
+
+    // Evaluate the objective for several (log beta, log gamma) points at once
+    std::vector<double> evaluate(const std::vector<std::vector<double>>& points);
+
+public:
+    Calibrator(const SIRModel& base, const std::vector<SIRCell>& initialCells,
+               const std::unordered_map<int, std::vector<int>>& neighbors,
+               const RowBuffer& observed, const BatchRunner& batchRunner);
+    ~Calibrator();
+
+    // Sum of squared errors of a single run with the given parameters
+    double objective(double beta, double gamma) const;
+
+    // Minimize the objective starting from (beta0, gamma0)
+    CalibrationResult fit(double beta0, double gamma0,
+                          int maxIterations = 200, double tolerance = 1e-8);
+};
+
+#endif // CALIBRATOR_H
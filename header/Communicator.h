@@ -0,0 +1,36 @@
+#ifndef COMMUNICATOR_H
+#define COMMUNICATOR_H
+
+#include <vector>
+#include "SIRCell.h"
+
+// Transport used by the simulation core. The core only talks to this
+// interface, so it can run under MPI (MPIHandler), in a single process
+// (SerialCommunicator) or under any other backend that implements it.
+class Communicator {
+public:
+    virtual ~Communicator() = default;
+
+    virtual int getRank() const = 0;
+    virtual int getSize() const = 0;
+
+    // Synchronize all participants at a step boundary
+    virtual void barrier() = 0;
+
+    // Per-step halo exchange, split so local work can overlap communication:
+    // send the boundary cells other processes need, then fill the halo
+    virtual void startHaloExchange(const std::vector<SIRCell>& grid) = 0;
+    virtual void finishHaloExchange(std::vector<SIRCell>& halo) = 0;
+};
+
+// Single-process backend: rank 0 of 1, all collectives are no-ops
+class SerialCommunicator : public Communicator {
+public:
+    int getRank() const override;
+    int getSize() const override;
+    void barrier() override;
+    void startHaloExchange(const std::vector<SIRCell>& grid) override;
+    void finishHaloExchange(std::vector<SIRCell>& halo) override;
+};
+
+#endif // COMMUNICATOR_H
@@ -8,31 +8,71 @@
 #include <string>
 #include "SIRCell.h"
 #include "SIRModel.h"
-#include <unordered_map>
+#include "Arena.h"
+#include "InSituAnalytics.h"
+#include "Communicator.h"
+#include "ParameterSchedule.h"
 
 class GridSimulation {
 private:
     std::vector<SIRCell> grid;
+    std::vector<SIRCell> nextGrid;        // Double buffer swapped each step
+    std::vector<SIRCell> neighborScratch; // Reused per-cell neighbor list
     SIRModel model;
-    int rank, size;
+    Communicator *comm; // Not owned
     std::unordered_map<int, std::vector<int>> neighborMap;
+    InSituAnalytics *analytics; // Optional, not owned
+
+    // Neighbor IDs in neighborMap are global; local cell i is global globalOffset + i.
+    // Neighbors owned by other processes are read from the halo.
+    int globalOffset;
+    std::vector<int> haloIds;    // Global IDs of the halo cells, in exchange order
+    std::vector<SIRCell> halo;
+
+    // Neighbors resolved to slots of [local cells | halo cells], in CSR form
+    std::vector<int> neighborStart;
+    std::vector<int> neighborSlot;
+    std::vector<int> interiorCells; // No halo neighbors
+    std::vector<int> boundaryCells; // At least one halo neighbor
+    bool neighborsResolved;
 
+    // Rates of each local cell for the current step
+    ParameterSchedule *schedule; // Optional, not owned
+    std::vector<double> cellBeta;
+    std::vector<double> cellGamma;
+
+    void resolveNeighbors();
+    void updateRates(int step);
+    void updateCells(const std::vector<int>& cells);
     
 public:
-    GridSimulation(const SIRModel& m, int mpiRank, int mpiSize);
+    GridSimulation(const SIRModel& m, Communicator& communicator);
     
     void setGrid(const std::vector<SIRCell>& initialGrid);
+
+    // Replace the model's constant beta and gamma (overridden by a schedule)
+    void setRates(double beta, double gamma);
     
     std::vector<SIRCell>& getGrid();
+    const std::vector<SIRCell>& getGrid() const;
     
     int getLocalSize() const;
     
     void updateGrid();
     void updateGridNew();
     void setNeighborMap(const std::unordered_map<int, std::vector<int>>& map);
+    void setAnalytics(InSituAnalytics *stage);
+    void setSchedule(ParameterSchedule *parameterSchedule);
+    void setGlobalOffset(int offset);
+    void setHaloCells(const std::vector<int>& globalIds);
+    const std::vector<SIRCell>& getHalo() const;
 
     
-    std::vector<std::vector<double>> runSimulation();
+    // Advance one step and append [time, avg_S, avg_I, avg_R] to results
+    void advance(int step, RowBuffer& results);
+    
+    // Run all steps, storing per-step averages in an arena-backed buffer
+    RowBuffer runSimulation(Arena& arena);
 
     static std::map<std::string, int> createCellsMap();
     static std::map<int, std::list<int>> divideIntoBlocks(
@@ -0,0 +1,81 @@
+#ifndef INSITUANALYTICS_H
+#define INSITUANALYTICS_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "SIRCell.h"
+
+// Runs lightweight analysis of the local grid on a background thread while
+// the simulation keeps stepping. Only compact per-region summaries are kept:
+// infection peak time/height, effective reproduction number R_eff = beta*S/gamma,
+// and a top-k ranking of the hottest cells.
+class InSituAnalytics {
+private:
+    struct Snapshot {
+        int step;
+        double time;
+        std::vector<double> S;
+        std::vector<double> I;
+        std::vector<double> ratio; // beta / gamma of each cell at this step
+    };
+
+    int numCells;
+
+    // Per-region summaries (indexed by local cell)
+    std::vector<double> peakI;
+    std::vector<double> peakTime;
+    std::vector<double> finalReff;
+    std::vector<double> reffBelowOneTime; // First time R_eff < 1, -1 if never
+
+    // Mean R_eff over the local cells, one entry per processed step
+    std::vector<double> meanReff;
+    std::vector<double> stepTimes;
+
+    // Snapshot pool: buffers cycle between the free list and the work queue
+    std::vector<Snapshot> pool;
+    std::vector<Snapshot *> freeList;
+    std::deque<Snapshot *> queue;
+    std::mutex mutex;
+    std::condition_variable queueReady;
+    std::condition_variable bufferFree;
+    bool stopping;
+    std::thread worker;
+
+    void workerLoop();
+    void process(const Snapshot &snapshot);
+
+public:
+    explicit InSituAnalytics(int poolSize = 4);
+    ~InSituAnalytics();
+
+    InSituAnalytics(const InSituAnalytics&) = delete;
+    InSituAnalytics& operator=(const InSituAnalytics&) = delete;
+
+    // Size the summaries for the local grid and start the worker thread
+    void start(int localCells);
+
+    // Copy the current grid and per-cell rates into a pooled snapshot and queue
+    // it for analysis; blocks only if every snapshot is still waiting to be processed
+    void submit(int step, double time, const std::vector<SIRCell>& grid,
+                const double *cellBeta, const double *cellGamma);
+
+    // Drain the queue and join the worker thread
+    void finish();
+
+    // Getters (valid after finish)
+    int getNumCells() const;
+    const std::vector<double>& getPeakI() const;
+    const std::vector<double>& getPeakTime() const;
+    const std::vector<double>& getFinalReff() const;
+    const std::vector<double>& getReffBelowOneTime() const;
+    const std::vector<double>& getMeanReff() const;
+    const std::vector<double>& getStepTimes() const;
+
+    // Indices of the k local cells with the highest infection peak
+    std::vector<int> topK(int k) const;
+};
+
+#endif // INSITUANALYTICS_H
@@ -1,28 +1,76 @@
 #ifndef MPIHANDLER_H
 #define MPIHANDLER_H
 
+#include <mpi.h>
 #include <vector>
+#include <unordered_map>
 #include "SIRCell.h"
+#include "Arena.h"
+#include "InSituAnalytics.h"
+#include "Communicator.h"
+#include "Calibrator.h"
 
-class MPIHandler {
+// MPI backend of the simulation core
+class MPIHandler : public Communicator {
 private:
     int rank, size;
+    int localOffset; // Global index of the first local row
+    int localRows;
+    int totalRows;
+    
+    // Neighborhood topology built from the cell adjacency (MPI_COMM_NULL until set up)
+    MPI_Comm topoComm;
+    std::vector<int> sendCells;              // Local cells to send, in destination order
+    std::vector<int> sendCounts, sendDispls; // Per destination, in doubles
+    std::vector<int> recvCounts, recvDispls; // Per source, in doubles
+    std::vector<double> sendBuffer, recvBuffer;
+    MPI_Request haloRequest;
+    bool haloPending;
+    
+    // Rank owning a global row under the block distribution
+    int ownerOf(int globalRow) const;
     
 public:
     MPIHandler(int argc, char *argv[]);
     ~MPIHandler();
     
-    int getRank() const;
-    int getSize() const;
+    int getRank() const override;
+    int getSize() const override;
+    void barrier() override;
+    int getLocalOffset() const;
+    
+    // Build a distributed graph communicator linking ranks that own adjacent
+    // cells; returns the global IDs of the halo cells this rank receives
+    std::vector<int> setupTopology(const std::unordered_map<int, std::vector<int>>& neighborMap);
+    
+    // Neighborhood halo exchange over the topology communicator
+    void startHaloExchange(const std::vector<SIRCell>& grid) override;
+    void finishHaloExchange(std::vector<SIRCell>& halo) override;
+    
+    // Distribute data among processes (message buffers come from the arena)
+    std::vector<SIRCell> distributeData(const RowBuffer& fullData, Arena& arena);
     
-    // Distribute data among processes
-    std::vector<SIRCell> distributeData(const std::vector<std::vector<double>>& fullData);
+    // Copy rank 0's rows to every process (buffer allocated from the arena)
+    void broadcastRows(RowBuffer& rows, Arena& arena);
     
-    // Gather results from all processes
-    std::vector<double> gatherResults(const std::vector<std::vector<double>>& localResults);
+    // Pick the lowest-error calibration over all ranks; every rank gets the winner
+    CalibrationResult selectBestCalibration(const CalibrationResult& local);
+    
+    // Gather results from all processes into an arena buffer on rank 0
+    RowBuffer gatherResults(const RowBuffer& localResults, Arena& arena);
     
     // Write results to file
-    void writeResults(const std::vector<double>& globalFlat, int steps);
+    void writeResults(const RowBuffer& globalResults, int steps);
+    
+    // Write results as compressed columns (lossless if maxError <= 0)
+    void writeCompressedResults(const RowBuffer& globalResults, int steps, double maxError);
+    
+    // Reduce each rank's top-k regions to a compact summary on rank 0;
+    // writeCells also streams the full per-region table to analytics_cells.csv
+    void writeAnalytics(const InSituAnalytics& analytics, int topK, bool writeCells);
+    
+    // Print arena and process peak memory of every rank on rank 0
+    void reportMemoryUsage(const Arena& arena);
 };
 
 #endif // MPIHANDLER_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef PARAMETERSCHEDULE_H
+#define PARAMETERSCHEDULE_H
+
+#include <cstddef>
+#include <vector>
+
+// Time-varying beta/gamma for groups of regions (lockdowns, vaccination,
+// seasonality). Each group has a piecewise-constant or piecewise-linear
+// table per parameter; discrete interventions are queued as events and
+// applied at step boundaries. Rates are resolved once per step into flat
+// per-cell arrays, so the RK4 kernel only ever sees plain scalars.
+// The schedule is not consumed by a run: rewind() replays it from step 0.
+class ParameterSchedule {
+public:
+    static const int BETA = 0;
+    static const int GAMMA = 1;
+
+    // Event operations
+    static const int SET = 0;   // Override the scheduled value
+    static const int SCALE = 1; // Multiply the current factor
+    static const int RESET = 2; // Drop overrides and factors
+
+    // Group used by knots and events that apply to every group
+    static const int ALL_GROUPS = -1;
+
+private:
+    struct Table {
+        std::vector<double> time;
+        std::vector<double> value;
+        bool linear = false;
+        size_t cursor = 0; // Last segment used; time only moves forward
+    };
+
+    struct Event {
+        int step;
+        int group;
+        int parameter;
+        int op;
+        double value;
+    };
+
+    double baseRate[2];
+    int numGroups;
+    std::vector<int> cellGroup; // Global cell -> group (missing cells use group 0)
+
+    // Table of (group g, parameter p) at 2 * (g + 1) + p; slots 0/1 hold the
+    // ALL_GROUPS defaults used by groups without their own table
+    std::vector<Table> tables;
+
+    // Per (group, parameter) event state and the resolved rate of the current step
+    std::vector<double> overrideValue;
+    std::vector<bool> hasOverride;
+    std::vector<double> scale;
+    std::vector<double> groupRate;
+
+    // Events sorted by step (same-step events in insertion order) and the next one to apply
+    std::vector<Event> events;
+    size_t nextEvent;
+
+    void ensureGroup(int group);
+    void checkTarget(int group, int parameter) const;
+
+    // Value of the table at the given time; before the first knot it is the fallback
+    double evaluateTable(Table& table, double time, double before);
+    void applyEvent(const Event& event, int group);
+
+public:
+    ParameterSchedule(double baseBeta, double baseGamma);
+
+    // Put a global cell into a group; groups are created on first use.
+    // Invalid arguments throw std::invalid_argument
+    void setCellGroup(int cell, int group);
+
+    // Add a knot (time, value) to the table of a group's parameter. Before its
+    // first knot a group follows the ALL_GROUPS table, which follows the base rate;
+    // all knots of a table must share the same mode
+    void addKnot(int group, int parameter, double time, double value, bool linear);
+
+    // Queue an intervention applied at the start of the given step
+    void scheduleEvent(int step, int group, int parameter, int op, double value);
+
+    // Apply due events and resolve every group's rates at the given time
+    void advanceTo(int step, double time);
+
+    // Undo every applied event so the next advanceTo replays the schedule from the start
+    void rewind();
+
+    // Gather the resolved rates for global cells [offset, offset + count)
+    void fillCellRates(int offset, int count, double *beta, double *gamma) const;
+
+    int getNumGroups() const;
+    double getGroupRate(int group, int parameter) const;
+};
+
+#endif // PARAMETERSCHEDULE_H
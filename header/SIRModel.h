@@ -23,6 +23,10 @@ public:
     // RK4 step function for SIR cell dynamics
     SIRCell rk4Step(const SIRCell &current) const;
     SIRCell rk4StepWithNeighbors(const SIRCell& current, const std::vector<SIRCell>& neighbors) const;
+    
+    // Same step with per-cell rates (held constant over the four stages)
+    SIRCell rk4StepWithNeighbors(const SIRCell& current, const std::vector<SIRCell>& neighbors,
+                                 double cellBeta, double cellGamma) const;
 
 };
 
@@ -0,0 +1,58 @@
+#ifndef SIMULATIONENGINE_H
+#define SIMULATIONENGINE_H
+
+#include <vector>
+#include <unordered_map>
+#include "SIRCell.h"
+#include "SIRModel.h"
+#include "Arena.h"
+#include "Communicator.h"
+#include "GridSimulation.h"
+
+// Embeddable front end of the simulation core. Builds a run from in-memory
+// arrays, steps it in-process and exposes the cells and per-step results
+// without copying. Runs serially unless another Communicator is supplied.
+class SimulationEngine {
+private:
+    SIRModel model;
+    SerialCommunicator serial;
+    Arena arena;
+    GridSimulation simulation;
+    RowBuffer results; // [time, avg_S, avg_I, avg_R] per completed step
+    int currentStep;
+
+public:
+    explicit SimulationEngine(const SIRModel& m);
+    SimulationEngine(const SIRModel& m, Communicator& comm);
+
+    SimulationEngine(const SimulationEngine&) = delete;
+    SimulationEngine& operator=(const SimulationEngine&) = delete;
+
+    // Load cell states from separate S/I/R arrays; restarts the run
+    void setCells(const double *S, const double *I, const double *R, int numCells);
+    void setCells(const std::vector<SIRCell>& cells);
+
+    // Replace beta and gamma, keeping dt and the step count; lets one engine serve many runs
+    void setRates(double beta, double gamma);
+
+    // Adjacency in CSR form: neighbors of cell c are neighbors[offsets[c] .. offsets[c+1])
+    void setNeighbors(const int *offsets, const int *neighbors, int numCells);
+    void setNeighborMap(const std::unordered_map<int, std::vector<int>>& map);
+
+    // Advance one step; returns false once the model's step count is reached
+    bool step();
+
+    // Advance until the model's step count is reached
+    const RowBuffer& run();
+
+    // Zero-copy views of the current state and the recorded results
+    const SIRCell *getCells() const;
+    int getNumCells() const;
+    const RowBuffer& getResults() const;
+    int getCurrentStep() const;
+
+    const SIRModel& getModel() const;
+    GridSimulation& getSimulation();
+};
+
+#endif // SIMULATIONENGINE_H
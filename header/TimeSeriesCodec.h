@@ -0,0 +1,38 @@
+#ifndef TIMESERIESCODEC_H
+#define TIMESERIESCODEC_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Compressed columnar storage for simulation time series.
+// Each column is encoded on its own, either
+//   - losslessly with Gorilla-style XOR encoding of consecutive doubles, or
+//   - with a bounded-error quantizer (|decoded - original| <= maxError)
+//     whose integer deltas are zigzag/varint encoded; a column where any value
+//     would miss the bound (e.g. maxError near the spacing of doubles) stays lossless.
+// The file format is self-describing, so decode needs nothing but the bytes.
+class TimeSeriesCodec {
+public:
+    static constexpr uint8_t GORILLA = 0;
+    static constexpr uint8_t QUANTIZED = 1;
+
+    struct Column {
+        std::string name;
+        std::vector<double> values;
+        bool quantizable = true; // False keeps the column lossless (e.g. time, IDs)
+    };
+
+    // maxError <= 0 selects lossless encoding for every column
+    static std::vector<uint8_t> encode(const std::vector<Column>& columns, double maxError);
+    static std::vector<Column> decode(const std::vector<uint8_t>& bytes);
+
+    static void writeFile(const std::string& filename, const std::vector<Column>& columns, double maxError);
+    static std::vector<Column> readFile(const std::string& filename);
+
+    // Write columns as CSV rows with round-trip precision
+    static void writeCSV(const std::vector<Column>& columns, std::ostream& out);
+};
+
+#endif // TIMESERIESCODEC_H
@@ -3,12 +3,22 @@
 #include "header/SIRModel.h"
 #include "header/CSVParser.h"
 #include "header/GridSimulation.h"
+#include "header/Arena.h"
+#include "header/InSituAnalytics.h"
+#include "header/Calibrator.h"
+#include "header/BatchRunner.h"
+#include "header/ParameterSchedule.h"
 #include <iostream>
 #include <unordered_map>
 #include <map>
 #include <list>
 #include <vector>
 #include <string>
+#include <stdexcept>
+#include <fstream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 
 #include <unordered_map>
 
@@ -31,6 +41,60 @@ std::unordered_map<int, std::vector<int>> build2DGridNeighborMap(int rows, int c
 }
 
 
+// Fit beta and gamma to observed per-region infections. Every rank runs
+// Nelder-Mead from its own starting point with threaded objective
+// evaluations, and the best fit over all ranks is reported.
+int runCalibration(MPIHandler& mpi, const SIRModel& model, RowBuffer& fullData,
+                   const std::string& observedFile, Arena& arena) {
+    RowBuffer observed;
+    if (mpi.getRank() == 0) {
+        try {
+            observed = CSVParser::loadObservedSeries(observedFile, arena);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    // Each objective evaluation is a full serial run, so every rank needs all data
+    mpi.broadcastRows(fullData, arena);
+    mpi.broadcastRows(observed, arena);
+
+    std::vector<SIRCell> cells;
+    for (size_t i = 0; i < fullData.getRows(); ++i) {
+        cells.push_back(CSVParser::mapToSIR(fullData.row(i)));
+    }
+
+    BatchRunner runner;
+    Calibrator calibrator(model, cells, build2DGridNeighborMap(8, 8), observed, runner);
+
+    // Multi-start: rank 0 starts at the model's rates, the others on a golden-angle
+    // spiral in log2 space filling a disc of radius 2 (factors up to 4x), so any
+    // number of ranks gets distinct, evenly spread starts
+    int rank = mpi.getRank();
+    double radius = 2.0 * std::sqrt(static_cast<double>(rank) / std::max(1, mpi.getSize() - 1));
+    double angle = 2.39996322972865332 * rank; // Golden angle in radians
+    double beta0 = model.getBeta() * std::pow(2.0, radius * std::cos(angle));
+    double gamma0 = model.getGamma() * std::pow(2.0, radius * std::sin(angle));
+    CalibrationResult local = calibrator.fit(beta0, gamma0);
+
+    CalibrationResult best = mpi.selectBestCalibration(local);
+    if (rank == 0) {
+        std::cout << "Calibrated beta = " << best.beta << ", gamma = " << best.gamma
+                  << " (error " << best.error << ", " << best.iterations << " iterations, "
+                  << best.evaluations << " evaluations over " << mpi.getSize() << " ranks x "
+                  << runner.getNumThreads() << " threads)" << std::endl;
+
+        std::ofstream outfile("calibration_result.csv");
+        outfile << "Beta,Gamma,Error,Iterations,Evaluations\n";
+        outfile << best.beta << "," << best.gamma << "," << best.error << ","
+                << best.iterations << "," << best.evaluations << "\n";
+        std::cout << "Calibration written to calibration_result.csv" << std::endl;
+    }
+    return 0;
+}
+
+
 int main(int argc, char *argv[]) {
 
     const int blockSize=4;
@@ -42,45 +106,161 @@ int main(int argc, char *argv[]) {
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
+    // Optional calibration mode: --calibrate <observed.csv>
+    // Optional time-varying rates: --interventions <interventions.csv>
+    // Optional compressed output: --output-format sirz [--max-error <e>]
+    // Optional per-region analytics table: --analytics-cells
+    std::string observedFile;
+    std::string interventionsFile;
+    std::string outputFormat;
+    std::string maxErrorArg;
+    bool analyticsCells = false;
+
+    // Every rank sees the same arguments, so all of them reach the barrier
+    auto rejectArgs = [&mpi](const std::string& message) {
+        if (mpi.getRank() == 0) {
+            std::cerr << "Error: " << message << std::endl;
+        }
+        mpi.barrier();
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--analytics-cells") {
+            analyticsCells = true;
+            continue;
+        }
+
+        std::string *value = nullptr;
+        if (arg == "--calibrate") {
+            value = &observedFile;
+        } else if (arg == "--interventions") {
+            value = &interventionsFile;
+        } else if (arg == "--output-format") {
+            value = &outputFormat;
+        } else if (arg == "--max-error") {
+            value = &maxErrorArg;
+        }
+
+        if (!value) {
+            rejectArgs("Unknown option '" + arg + "'");
+        } else if (i + 1 == argc || argv[i + 1][0] == '\0') {
+            rejectArgs(arg + " requires a value");
+        } else {
+            *value = argv[++i];
+        }
+    }
+
+    // Reject options that would otherwise be silently ignored
+    if (!observedFile.empty() && !interventionsFile.empty()) {
+        rejectArgs("--interventions cannot be combined with --calibrate (the fit uses constant rates)");
+    }
+    if (!observedFile.empty() && (!outputFormat.empty() || !maxErrorArg.empty() || analyticsCells)) {
+        rejectArgs("--output-format, --max-error and --analytics-cells do not apply to --calibrate");
+    }
+    if (outputFormat.empty()) {
+        outputFormat = "csv";
+    } else if (outputFormat != "csv" && outputFormat != "sirz") {
+        rejectArgs("Unknown output format '" + outputFormat + "' (expected csv or sirz)");
+    }
+    double maxError = 0.0;
+    if (!maxErrorArg.empty()) {
+        char *end;
+        maxError = std::strtod(maxErrorArg.c_str(), &end);
+        if (outputFormat != "sirz") {
+            rejectArgs("--max-error requires --output-format sirz");
+        } else if (*end != '\0' || !(maxError >= 0.0)) {
+            rejectArgs("Invalid --max-error value '" + maxErrorArg + "'");
+        }
+    }
+
     // Create SIR model with parameters
     SIRModel model(0.3, 0.1, 0.2, 100);
 
+    // Arena for parsed rows, message buffers and results of this rank
+    Arena arena;
+
     // Load data (only process 0)
-    std::vector<std::vector<double>> fullData;
+    RowBuffer fullData;
     if (mpi.getRank() == 0) {
-        fullData = CSVParser::loadUSStateData("../disease-simulation/data/sorted_initial_conditions.csv");
-        std::cout << "Total rows in input dataset: " << fullData.size() << "\n";
-
-        // Create cells and blocks using the sorted dataset
-        auto cells = GridSimulation::createCellsMap();
-        auto blocks = GridSimulation::divideIntoBlocks(cells, blockSize);
-
-        // Debug: Print blocks
-        for (const auto& [blockId, cellList] : blocks) {
-            std::cout << "Block " << blockId << ": ";
-            for (int cell : cellList) {
-                std::cout << cell << " ";
+        try {
+            fullData = CSVParser::loadUSStateData("../disease-simulation/data/sorted_initial_conditions.csv", arena);
+            std::cout << "Total rows in input dataset: " << fullData.getRows() << "\n";
+
+            // Create cells and blocks using the sorted dataset
+            auto cells = GridSimulation::createCellsMap();
+            auto blocks = GridSimulation::divideIntoBlocks(cells, blockSize);
+
+            // Debug: Print blocks
+            for (const auto& [blockId, cellList] : blocks) {
+                std::cout << "Block " << blockId << ": ";
+                for (int cell : cellList) {
+                    std::cout << cell << " ";
+                }
+                std::cout << "\n";
             }
-            std::cout << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
 
+    if (!observedFile.empty()) {
+        return runCalibration(mpi, model, fullData, observedFile, arena);
+    }
+
     // Distribute data among processes
-    std::vector<SIRCell> localGrid = mpi.distributeData(fullData);
+    std::vector<SIRCell> localGrid = mpi.distributeData(fullData, arena);
 
     // Create and run simulation
-    GridSimulation simulation(model, mpi.getRank(), mpi.getSize());
+    GridSimulation simulation(model, mpi);
     int rows = 8;
     int cols = 8; // So total = 64
 
     auto neighborMap = build2DGridNeighborMap(rows, cols);
     simulation.setNeighborMap(neighborMap);
     simulation.setGrid(localGrid);
-    std::vector<std::vector<double>> localResults = simulation.runSimulation();
+
+    // Neighbor IDs are global; cells owned by other ranks arrive through the halo
+    simulation.setGlobalOffset(mpi.getLocalOffset());
+    simulation.setHaloCells(mpi.setupTopology(neighborMap));
+
+    // The intervention file is small, so every rank reads its own copy
+    ParameterSchedule schedule(model.getBeta(), model.getGamma());
+    if (!interventionsFile.empty()) {
+        try {
+            CSVParser::loadInterventions(interventionsFile, schedule);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        simulation.setSchedule(&schedule);
+    }
+
+    // In-situ analytics run on a background thread while the grid steps
+    InSituAnalytics analytics;
+    analytics.start(simulation.getLocalSize());
+    simulation.setAnalytics(&analytics);
+
+    RowBuffer localResults = simulation.runSimulation(arena);
+    analytics.finish();
 
     // Gather and write results
-    std::vector<double> globalResults = mpi.gatherResults(localResults);
-    mpi.writeResults(globalResults, localResults.size());
+    RowBuffer globalResults = mpi.gatherResults(localResults, arena);
+    if (outputFormat == "sirz") {
+        try {
+            mpi.writeCompressedResults(globalResults, localResults.getRows(), maxError);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    } else {
+        mpi.writeResults(globalResults, localResults.getRows());
+    }
+    mpi.writeAnalytics(analytics, 5, analyticsCells);
+
+    mpi.reportMemoryUsage(arena);
 
     return 0;
 }
\ No newline at end of file
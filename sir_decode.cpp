@@ -0,0 +1,34 @@
+#include "header/TimeSeriesCodec.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+
+// Converts a compressed .sirz results file back to CSV, e.g. for
+// scripts/PlottingSIRModelResults.py. Needs no MPI.
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input.sirz> [output.csv]" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1];
+    std::string output = (argc > 2) ? argv[2] : "simulation_results.csv";
+
+    try {
+        auto columns = TimeSeriesCodec::readFile(input);
+
+        std::ofstream outfile(output);
+        if (!outfile) {
+            throw std::runtime_error("Error opening file " + output);
+        }
+        TimeSeriesCodec::writeCSV(columns, outfile);
+
+        size_t rows = columns.empty() ? 0 : columns[0].values.size();
+        std::cout << "Decoded " << columns.size() << " columns x " << rows
+                  << " rows from " << input << " to " << output << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "../header/Arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+Arena::Arena(size_t initialBytes)
+    : blockSize(std::max<size_t>(initialBytes, 4096)), used(0), peak(0), reserved(0) {}
+
+void *Arena::allocateBytes(size_t bytes, size_t alignment) {
+    if (bytes == 0) {
+        bytes = 1;
+    }
+
+    // Try to fit the request into the current block
+    if (!blocks.empty()) {
+        Block &current = blocks.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(current.data.get());
+        uintptr_t aligned = (base + current.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t offset = aligned - base;
+        if (offset + bytes <= current.capacity) {
+            used += offset + bytes - current.used;
+            current.used = offset + bytes;
+            peak = std::max(peak, used);
+            return reinterpret_cast<void *>(aligned);
+        }
+    }
+
+    // Otherwise start a new block; oversized requests get a block of their own
+    size_t capacity = std::max(blockSize, bytes + alignment);
+    Block block{std::unique_ptr<char[]>(new char[capacity]), capacity, 0};
+    reserved += capacity;
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t aligned = (base + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    block.used = (aligned - base) + bytes;
+    used += block.used;
+    peak = std::max(peak, used);
+
+    blocks.push_back(std::move(block));
+    return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::reset() {
+    if (blocks.empty()) {
+        return;
+    }
+
+    // Keep the largest block so the next run does not hit the allocator again
+    auto largest = std::max_element(blocks.begin(), blocks.end(),
+        [](const Block &a, const Block &b) { return a.capacity < b.capacity; });
+    Block keep = std::move(*largest);
+    blocks.clear();
+    keep.used = 0;
+    reserved = keep.capacity;
+    blocks.push_back(std::move(keep));
+    used = 0;
+}
+
+size_t Arena::getUsed() const {
+    return used;
+}
+
+size_t Arena::getPeak() const {
+    return peak;
+}
+
+size_t Arena::getReserved() const {
+    return reserved;
+}
+
+RowBuffer::RowBuffer()
+    : values(nullptr), rows(0), cols(0), capacity(0) {}
+
+RowBuffer::RowBuffer(Arena& arena, size_t maxRows, size_t numCols)
+    : values(arena.allocate<double>(maxRows * numCols)), rows(0), cols(numCols), capacity(maxRows) {}
+
+bool RowBuffer::appendRow(const double *row) {
+    if (rows >= capacity) {
+        return false;
+    }
+    std::memcpy(values + rows * cols, row, cols * sizeof(double));
+    rows++;
+    return true;
+}
+
+void RowBuffer::resize(size_t numRows) {
+    rows = std::min(numRows, capacity);
+}
+
+double *RowBuffer::row(size_t i) {
+    return values + i * cols;
+}
+
+const double *RowBuffer::row(size_t i) const {
+    return values + i * cols;
+}
+
+double *RowBuffer::data() {
+    return values;
+}
+
+const double *RowBuffer::data() const {
+    return values;
+}
+
+size_t RowBuffer::getRows() const {
+    return rows;
+}
+
+size_t RowBuffer::getCols() const {
+    return cols;
+}
+
+size_t RowBuffer::getCapacity() const {
+    return capacity;
+}
+
+bool RowBuffer::empty() const {
+    return rows == 0;
+}
@@ -0,0 +1,54 @@
+#include "../header/BatchRunner.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+BatchRunner::BatchRunner(int threads) : numThreads(threads) {
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+int BatchRunner::getNumThreads() const {
+    return numThreads;
+}
+
+void BatchRunner::run(int numJobs, const std::function<void(int)>& job) const {
+    std::atomic<int> next(0);
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    // Workers pull job indices until none are left
+    auto worker = [&]() {
+        for (int i = next++; i < numJobs; i = next++) {
+            try {
+                job(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+    };
+
+    int threads = std::min(numThreads, numJobs);
+    if (threads <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+        for (auto &thread : pool) {
+            thread.join();
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
@@ -2,10 +2,11 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <mpi.h>
 #include <unordered_map>
 #include <map>
 #include <algorithm>
+#include <iterator>
+#include <stdexcept>
 
 std::string CSVParser::trim(const std::string &s) {
     size_t start = s.find_first_not_of(" \t\r\n");
@@ -13,19 +14,31 @@ std::string CSVParser::trim(const std::string &s) {
     return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
 }
 
-std::vector<std::vector<double>> CSVParser::loadUSStateData(const std::string& filename) {
+size_t CSVParser::countLines(std::istream &in) {
+    size_t lines = std::count(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), '\n') + 1;
+    
+    // Rewind for the parsing pass
+    in.clear();
+    in.seekg(0);
+    return lines;
+}
+
+RowBuffer CSVParser::loadUSStateData(const std::string& filename, Arena& arena) {
     std::ifstream infile(filename);
     if (!infile) {
-        std::cerr << "Error opening file " << filename << "\n";
-        MPI_Abort(MPI_COMM_WORLD, 1);
+        throw std::runtime_error("Error opening file " + filename);
     }
     
+    // Count lines in a first pass so the row region can be sized up front
+    size_t maxRows = countLines(infile);
+    
     std::string line;
     bool headerFound = false;
     int lineCount = 0;
     
-    // Each row will be stored as a vector of double
-    std::vector<std::vector<double>> data;
+    // Each row is stored flat as [lat, lon, confirmed, deaths, recovered, active]
+    RowBuffer data(arena, maxRows, ROW_COLUMNS);
+    std::vector<std::string> tokens;
     
     // Process lines until we find valid data
     while (std::getline(infile, line)) {
@@ -50,7 +63,7 @@ std::vector<std::vector<double>> CSVParser::loadUSStateData(const std::string& f
         // Process data line
         std::istringstream ss(line);
         std::string token;
-        std::vector<std::string> tokens;
+        tokens.clear();
         
         // Split line on commas
         while (std::getline(ss, token, ',')) {
@@ -73,7 +86,8 @@ std::vector<std::vector<double>> CSVParser::loadUSStateData(const std::string& f
             double active = std::stod(tokens[8]);
             
             // Store values
-            data.push_back({lat, lon, confirmed, deaths, recovered, active});
+            const double row[ROW_COLUMNS] = {lat, lon, confirmed, deaths, recovered, active};
+            data.appendRow(row);
         } catch (const std::invalid_argument& e) {
             std::cerr << "Invalid value at line " << lineCount << ": " << line << "\nError: " << e.what() << std::endl;
             continue;
@@ -83,11 +97,160 @@ std::vector<std::vector<double>> CSVParser::loadUSStateData(const std::string& f
         }
     }
     
-    std::cout << "Successfully parsed " << data.size() << " data rows from CSV." << std::endl;
+    std::cout << "Successfully parsed " << data.getRows() << " data rows from CSV." << std::endl;
+    return data;
+}
+
+RowBuffer CSVParser::loadObservedSeries(const std::string& filename, Arena& arena) {
+    std::ifstream infile(filename);
+    if (!infile) {
+        throw std::runtime_error("Error opening file " + filename);
+    }
+    
+    // Count lines in a first pass so the row region can be sized up front
+    size_t maxRows = countLines(infile);
+    
+    // The header fixes the number of columns
+    std::string line;
+    if (!std::getline(infile, line)) {
+        throw std::runtime_error("Empty observation file " + filename);
+    }
+    size_t numCols = std::count(line.begin(), line.end(), ',') + 1;
+    
+    RowBuffer data(arena, maxRows, numCols);
+    std::vector<double> values(numCols);
+    int lineCount = 1;
+    
+    while (std::getline(infile, line)) {
+        lineCount++;
+        if (trim(line).empty()) continue;
+        
+        std::istringstream ss(line);
+        std::string token;
+        size_t col = 0;
+        try {
+            while (col < numCols && std::getline(ss, token, ',')) {
+                values[col++] = std::stod(trim(token));
+            }
+        } catch (const std::runtime_error&) {
+            throw;
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value at line " << lineCount << ": " << line << "\nError: " << e.what() << std::endl;
+            continue;
+        }
+        
+        if (col < numCols) {
+            std::cerr << "Line " << lineCount << " has fewer than " << numCols << " columns: " << line << std::endl;
+            continue;
+        }
+        data.appendRow(values.data());
+    }
+    
+    std::cout << "Successfully parsed " << data.getRows() << " observation rows from CSV." << std::endl;
     return data;
 }
 
-SIRCell CSVParser::mapToSIR(const std::vector<double>& rowData) {
+void CSVParser::loadInterventions(const std::string& filename, ParameterSchedule& schedule) {
+    std::ifstream infile(filename);
+    if (!infile) {
+        throw std::runtime_error("Error opening file " + filename);
+    }
+    
+    std::string line;
+    std::vector<std::string> tokens;
+    int lineCount = 0;
+    int knots = 0, events = 0;
+    
+    while (std::getline(infile, line)) {
+        lineCount++;
+        line = trim(line.substr(0, line.find('#'))); // '#' starts a comment
+        if (line.empty()) continue;
+        
+        // Bad targets and conflicting knots abort the load rather than silently changing the schedule
+        auto reject = [&](const std::string& reason) {
+            throw std::runtime_error("Invalid intervention at line " + std::to_string(lineCount) + ": " + reason);
+        };
+        
+        std::istringstream ss(line);
+        std::string token;
+        tokens.clear();
+        while (std::getline(ss, token, ',')) {
+            tokens.push_back(trim(token));
+        }
+        tokens.resize(6);
+        
+        const std::string& kind = tokens[0];
+        if (kind == "Kind") continue; // Header
+        
+        try {
+            if (kind == "group") {
+                if (tokens[1] == "*" || tokens[4] == "*") {
+                    reject("group rows need an explicit region and group");
+                }
+                int cell = std::stoi(tokens[1]), group = std::stoi(tokens[4]);
+                if (cell < 0 || group < 0) {
+                    reject("region and group must be non-negative");
+                }
+                schedule.setCellGroup(cell, group);
+                continue;
+            }
+            
+            int target = (tokens[1] == "*") ? ParameterSchedule::ALL_GROUPS : std::stoi(tokens[1]);
+            if (target < 0 && target != ParameterSchedule::ALL_GROUPS) {
+                reject("target must be * or a non-negative group");
+            }
+            
+            int parameter;
+            if (tokens[2] == "beta") {
+                parameter = ParameterSchedule::BETA;
+            } else if (tokens[2] == "gamma") {
+                parameter = ParameterSchedule::GAMMA;
+            } else {
+                std::cerr << "Unknown parameter at line " << lineCount << ": " << line << std::endl;
+                continue;
+            }
+            
+            if (kind == "knot") {
+                if (tokens[5] != "linear" && tokens[5] != "step" && !tokens[5].empty()) {
+                    reject("unknown knot mode '" + tokens[5] + "'");
+                }
+                double when = std::stod(tokens[3]), value = std::stod(tokens[4]);
+                try {
+                    schedule.addKnot(target, parameter, when, value, tokens[5] == "linear");
+                } catch (const std::invalid_argument& e) {
+                    reject(e.what());
+                }
+                knots++;
+            } else if (kind == "event") {
+                int op;
+                if (tokens[5] == "set") {
+                    op = ParameterSchedule::SET;
+                } else if (tokens[5] == "scale") {
+                    op = ParameterSchedule::SCALE;
+                } else if (tokens[5] == "reset") {
+                    op = ParameterSchedule::RESET;
+                } else {
+                    std::cerr << "Unknown event operation at line " << lineCount << ": " << line << std::endl;
+                    continue;
+                }
+                double value = tokens[4].empty() ? 0.0 : std::stod(tokens[4]);
+                schedule.scheduleEvent(std::stoi(tokens[3]), target, parameter, op, value);
+                events++;
+            } else {
+                std::cerr << "Unknown row kind at line " << lineCount << ": " << line << std::endl;
+            }
+        } catch (const std::runtime_error&) {
+            throw;
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value at line " << lineCount << ": " << line << "\nError: " << e.what() << std::endl;
+        }
+    }
+    
+    std::cout << "Loaded " << schedule.getNumGroups() << " region groups, " << knots
+              << " schedule knots and " << events << " events from " << filename << std::endl;
+}
+
+SIRCell CSVParser::mapToSIR(const double *rowData) {
     // rowData: [lat, lon, confirmed, deaths, recovered, active]
     
     // Calculate total population - if not available, estimate based on cases
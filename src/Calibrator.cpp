@@ -0,0 +1,199 @@
+#include "../header/Calibrator.h"
+#include "../header/SimulationEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+Calibrator::Calibrator(const SIRModel& base, const std::vector<SIRCell>& initialCells,
+                       const std::unordered_map<int, std::vector<int>>& neighbors,
+                       const RowBuffer& observed, const BatchRunner& batchRunner)
+    : baseModel(base), cells(initialCells), neighborMap(neighbors), runner(batchRunner),
+      numRegions(0), evaluations(0) {
+    if (observed.getCols() < 2) {
+        throw std::invalid_argument("Observations need a time column and at least one region");
+    }
+    numRegions = std::min(static_cast<int>(observed.getCols()) - 1, static_cast<int>(cells.size()));
+
+    // Map each observation time to the step whose result carries that time
+    for (size_t r = 0; r < observed.getRows(); ++r) {
+        const double *row = observed.row(r);
+        int step = static_cast<int>(std::lround(row[0] / baseModel.getDt()));
+        if (step < 0 || step >= baseModel.getNumSteps()) {
+            continue;
+        }
+        observedStep.push_back(step);
+        observedI.insert(observedI.end(), row + 1, row + 1 + numRegions);
+    }
+
+    // Keep observations in step order so a run can stop after the last one
+    std::vector<size_t> order(observedStep.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [this](size_t a, size_t b) { return observedStep[a] < observedStep[b]; });
+    std::vector<int> sortedStep;
+    std::vector<double> sortedI;
+    for (size_t k : order) {
+        sortedStep.push_back(observedStep[k]);
+        sortedI.insert(sortedI.end(), observedI.begin() + k * numRegions,
+                       observedI.begin() + (k + 1) * numRegions);
+    }
+    observedStep.swap(sortedStep);
+    observedI.swap(sortedI);
+}
+
+Calibrator::~Calibrator() = default;
+
+SimulationEngine *Calibrator::acquireEngine() const {
+    {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        if (!freeEngines.empty()) {
+            SimulationEngine *engine = freeEngines.back();
+            freeEngines.pop_back();
+            return engine;
+        }
+    }
+
+    // No idle engine: build one outside the lock (at most one per concurrent evaluation)
+    std::unique_ptr<SimulationEngine> engine(new SimulationEngine(baseModel));
+    engine->setNeighborMap(neighborMap);
+    std::lock_guard<std::mutex> lock(engineMutex);
+    engines.push_back(std::move(engine));
+    return engines.back().get();
+}
+
+void Calibrator::releaseEngine(SimulationEngine *engine) const {
+    std::lock_guard<std::mutex> lock(engineMutex);
+    freeEngines.push_back(engine);
+}
+
+double Calibrator::objective(double beta, double gamma) const {
+    if (observedStep.empty()) {
+        return 0.0;
+    }
+
+    // Restart a pooled engine instead of building a fresh one per evaluation
+    SimulationEngine &engine = *acquireEngine();
+    engine.setRates(beta, gamma);
+    engine.setCells(cells);
+
+    double error = 0.0;
+    size_t k = 0;
+    for (int step = 0; step <= observedStep.back(); ++step) {
+        engine.step();
+
+        // Compare every observation recorded at this step
+        const SIRCell *state = engine.getCells();
+        for (; k < observedStep.size() && observedStep[k] == step; ++k) {
+            const double *obs = &observedI[k * numRegions];
+            for (int r = 0; r < numRegions; ++r) {
+                double diff = state[r].getI() - obs[r];
+                error += diff * diff;
+            }
+        }
+    }
+    releaseEngine(&engine);
+    return error;
+}
+
+std::vector<double> Calibrator::evaluate(const std::vector<std::vector<double>>& points) {
+    std::vector<double> values(points.size());
+    runner.run(static_cast<int>(points.size()), [&](int i) {
+        values[i] = objective(std::exp(points[i][0]), std::exp(points[i][1]));
+    });
+    evaluations += static_cast<int>(points.size());
+    return values;
+}
+
+CalibrationResult Calibrator::fit(double beta0, double gamma0, int maxIterations, double tolerance) {
+    // Search in log space so both rates stay positive
+    const int n = 2;
+    std::vector<std::vector<double>> simplex = {
+        {std::log(beta0), std::log(gamma0)},
+        {std::log(beta0) + 0.1, std::log(gamma0)},
+        {std::log(beta0), std::log(gamma0) + 0.1}
+    };
+    evaluations = 0;
+    std::vector<double> values = evaluate(simplex);
+
+    auto blend = [](const std::vector<double>& a, const std::vector<double>& b, double t) {
+        // a + t * (b - a)
+        return std::vector<double>{a[0] + t * (b[0] - a[0]), a[1] + t * (b[1] - a[1])};
+    };
+
+    int iteration = 0;
+    for (; iteration < maxIterations; ++iteration) {
+        // Order vertices from best to worst
+        std::vector<int> order(n + 1);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+        std::vector<std::vector<double>> sortedSimplex;
+        std::vector<double> sortedValues;
+        for (int i : order) {
+            sortedSimplex.push_back(simplex[i]);
+            sortedValues.push_back(values[i]);
+        }
+        simplex.swap(sortedSimplex);
+        values.swap(sortedValues);
+
+        if (values[n] - values[0] <= tolerance) {
+            break;
+        }
+
+        // Centroid of all but the worst vertex
+        std::vector<double> centroid(n, 0.0);
+        for (int i = 0; i < n; ++i) {
+            for (int d = 0; d < n; ++d) {
+                centroid[d] += simplex[i][d] / n;
+            }
+        }
+
+        // Evaluate every candidate move of this iteration in parallel
+        std::vector<std::vector<double>> candidates = {
+            blend(centroid, simplex[n], -1.0), // reflection
+            blend(centroid, simplex[n], -2.0), // expansion
+            blend(centroid, simplex[n], -0.5), // outside contraction
+            blend(centroid, simplex[n], 0.5)   // inside contraction
+        };
+        std::vector<double> f = evaluate(candidates);
+
+        bool shrink = false;
+        if (f[0] < values[0]) {
+            int pick = f[1] < f[0] ? 1 : 0;
+            simplex[n] = candidates[pick];
+            values[n] = f[pick];
+        } else if (f[0] < values[n - 1]) {
+            simplex[n] = candidates[0];
+            values[n] = f[0];
+        } else if (f[0] < values[n]) {
+            if (f[2] <= f[0]) {
+                simplex[n] = candidates[2];
+                values[n] = f[2];
+            } else {
+                shrink = true;
+            }
+        } else if (f[3] < values[n]) {
+            simplex[n] = candidates[3];
+            values[n] = f[3];
+        } else {
+            shrink = true;
+        }
+
+        // Pull every vertex halfway towards the best one
+        if (shrink) {
+            std::vector<std::vector<double>> shrunk;
+            for (int i = 1; i <= n; ++i) {
+                shrunk.push_back(blend(simplex[0], simplex[i], 0.5));
+            }
+            std::vector<double> shrunkValues = evaluate(shrunk);
+            for (int i = 1; i <= n; ++i) {
+                simplex[i] = shrunk[i - 1];
+                values[i] = shrunkValues[i - 1];
+            }
+        }
+    }
+
+    int best = static_cast<int>(std::min_element(values.begin(), values.end()) - values.begin());
+    return CalibrationResult{std::exp(simplex[best][0]), std::exp(simplex[best][1]),
+                             values[best], iteration, evaluations};
+}
@@ -0,0 +1,15 @@
+#include "../header/Communicator.h"
+
+int SerialCommunicator::getRank() const {
+    return 0;
+}
+
+int SerialCommunicator::getSize() const {
+    return 1;
+}
+
+void SerialCommunicator::barrier() {}
+
+void SerialCommunicator::startHaloExchange(const std::vector<SIRCell>&) {}
+
+void SerialCommunicator::finishHaloExchange(std::vector<SIRCell>&) {}
@@ -1,5 +1,4 @@
 #include "../header/GridSimulation.h"
-#include <mpi.h>
 #include <unordered_map>
 #include <map>
 #include <list>
@@ -7,18 +6,36 @@
 #include <algorithm>
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
 
-GridSimulation::GridSimulation(const SIRModel& m, int mpiRank, int mpiSize) 
-    : model(m), rank(mpiRank), size(mpiSize) {}
+GridSimulation::GridSimulation(const SIRModel& m, Communicator& communicator) 
+    : model(m), comm(&communicator), analytics(nullptr), globalOffset(0), neighborsResolved(false),
+      schedule(nullptr) {}
 
 void GridSimulation::setGrid(const std::vector<SIRCell>& initialGrid) {
+    // Resolved neighbors only depend on the number of local cells
+    if (initialGrid.size() != grid.size()) {
+        neighborsResolved = false;
+    }
     grid = initialGrid;
 }
 
+void GridSimulation::setRates(double beta, double gamma) {
+    model = SIRModel(beta, gamma, model.getDt(), model.getNumSteps());
+    if (!schedule) {
+        cellBeta.assign(grid.size(), beta);
+        cellGamma.assign(grid.size(), gamma);
+    }
+}
+
 std::vector<SIRCell>& GridSimulation::getGrid() {
     return grid;
 }
 
+const std::vector<SIRCell>& GridSimulation::getGrid() const {
+    return grid;
+}
+
 int GridSimulation::getLocalSize() const {
     return grid.size();
 }
@@ -27,46 +44,135 @@ int GridSimulation::getLocalSize() const {
 void GridSimulation::setNeighborMap(const std::unordered_map<int, std::vector<int>>& map) {
 
     neighborMap = map;
+    neighborsResolved = false;
 
 }
 
-void GridSimulation::updateGrid() {
-    std::vector<SIRCell> newGrid = grid;
-    for (size_t i = 0; i < grid.size(); ++i) {
-        newGrid[i] = model.rk4Step(grid[i]);
+void GridSimulation::setSchedule(ParameterSchedule *parameterSchedule) {
+    schedule = parameterSchedule;
+    cellBeta.clear();
+    cellGamma.clear();
+}
+
+void GridSimulation::updateRates(int step) {
+    if (!schedule) {
+        return;
+    }
+
+    // Resolve the schedule once per step into flat per-cell arrays
+    cellBeta.resize(grid.size());
+    cellGamma.resize(grid.size());
+    // A run starting over replays the schedule instead of continuing from its end state
+    if (step == 0) {
+        schedule->rewind();
     }
-    grid = newGrid;
+    schedule->advanceTo(step, step * model.getDt());
+    schedule->fillCellRates(globalOffset, static_cast<int>(grid.size()), cellBeta.data(), cellGamma.data());
 }
 
-void GridSimulation::updateGridNew() {
-    std::vector<SIRCell> newGrid = grid;
+void GridSimulation::setGlobalOffset(int offset) {
+    globalOffset = offset;
+    neighborsResolved = false;
+}
 
-    for (size_t i = 0; i < grid.size(); ++i) {
-        std::vector<SIRCell> neighbors;
-
-        // Get neighbors from map (if exists)
-        if (neighborMap.find(i) != neighborMap.end()) {
-            const std::vector<int>& neighborIDs = neighborMap[i];
-            for (int j : neighborIDs) {
-                if (j >= 0 && j < static_cast<int>(grid.size())) {
-                    neighbors.push_back(grid[j]);
+void GridSimulation::setHaloCells(const std::vector<int>& globalIds) {
+    haloIds = globalIds;
+    halo.assign(haloIds.size(), SIRCell());
+    neighborsResolved = false;
+}
+
+const std::vector<SIRCell>& GridSimulation::getHalo() const {
+    return halo;
+}
+
+void GridSimulation::resolveNeighbors() {
+    int localSize = static_cast<int>(grid.size());
+    std::unordered_map<int, int> haloSlot;
+    for (size_t k = 0; k < haloIds.size(); ++k) {
+        haloSlot[haloIds[k]] = localSize + static_cast<int>(k);
+    }
+
+    // Translate global neighbor IDs once into slots of [local cells | halo cells]
+    neighborStart.assign(1, 0);
+    neighborSlot.clear();
+    interiorCells.clear();
+    boundaryCells.clear();
+    for (int i = 0; i < localSize; ++i) {
+        bool touchesHalo = false;
+        auto it = neighborMap.find(globalOffset + i);
+        if (it != neighborMap.end()) {
+            for (int j : it->second) {
+                if (j >= globalOffset && j < globalOffset + localSize) {
+                    neighborSlot.push_back(j - globalOffset);
+                } else {
+                    auto h = haloSlot.find(j);
+                    if (h != haloSlot.end()) {
+                        neighborSlot.push_back(h->second);
+                        touchesHalo = true;
+                    }
                 }
             }
         }
+        neighborStart.push_back(static_cast<int>(neighborSlot.size()));
+        (touchesHalo ? boundaryCells : interiorCells).push_back(i);
+    }
+
+    neighborsResolved = true;
+}
+
+void GridSimulation::updateCells(const std::vector<int>& cells) {
+    int localSize = static_cast<int>(grid.size());
+    for (int i : cells) {
+        // Reuse the scratch buffer instead of allocating per cell
+        neighborScratch.clear();
+        for (int k = neighborStart[i]; k < neighborStart[i + 1]; ++k) {
+            int slot = neighborSlot[k];
+            neighborScratch.push_back(slot < localSize ? grid[slot] : halo[slot - localSize]);
+        }
 
         // Use model to compute update using neighbors
-        newGrid[i] = model.rk4StepWithNeighbors(grid[i], neighbors);
+        nextGrid[i] = model.rk4StepWithNeighbors(grid[i], neighborScratch, cellBeta[i], cellGamma[i]);
     }
+}
+
+void GridSimulation::setAnalytics(InSituAnalytics *stage) {
+    analytics = stage;
+}
 
-    grid = newGrid;
+void GridSimulation::updateGrid() {
+    nextGrid.resize(grid.size());
+    for (size_t i = 0; i < grid.size(); ++i) {
+        nextGrid[i] = model.rk4Step(grid[i]);
+    }
+    grid.swap(nextGrid);
+}
+
+void GridSimulation::updateGridNew() {
+    if (!neighborsResolved) {
+        resolveNeighbors();
+    }
+    nextGrid.resize(grid.size());
+
+    // Without a schedule every cell uses the model's constant rates
+    if (cellBeta.size() != grid.size()) {
+        cellBeta.assign(grid.size(), model.getBeta());
+        cellGamma.assign(grid.size(), model.getGamma());
+    }
+
+    // Interior cells only read local state, so they overlap the halo exchange
+    comm->startHaloExchange(grid);
+    updateCells(interiorCells);
+    comm->finishHaloExchange(halo);
+    updateCells(boundaryCells);
+
+    grid.swap(nextGrid);
 }
 
 std::map<std::string, int> GridSimulation::createCellsMap() {
     std::map<std::string, int> cells;
     std::ifstream infile("../disease-simulation/data/sorted_initial_conditions.csv");
     if (!infile) {
-        std::cerr << "Error: Could not open sorted_initial_conditions.csv\n";
-        MPI_Abort(MPI_COMM_WORLD, 1);
+        throw std::runtime_error("Could not open sorted_initial_conditions.csv");
     }
 
     std::string line;
@@ -106,31 +212,40 @@ std::map<int, std::list<int>> GridSimulation::divideIntoBlocks(
     return blocks;
 }
 
-std::vector<std::vector<double>> GridSimulation::runSimulation() {
-    std::vector<std::vector<double>> results; // [time, avg_S, avg_I, avg_R]
+void GridSimulation::advance(int step, RowBuffer& results) {
+    // Update grid with the rates in effect at this step
+    updateRates(step);
+    updateGridNew();
+    
+    // Compute average S, I, R
+    double sumS = 0, sumI = 0, sumR = 0;
+    for (auto &cell : grid) {
+        sumS += cell.getS();
+        sumI += cell.getI();
+        sumR += cell.getR();
+    }
+    
+    double avgS = sumS / grid.size();
+    double avgI = sumI / grid.size();
+    double avgR = sumR / grid.size();
+    double timeVal = step * model.getDt();
+    
+    const double row[4] = {timeVal, avgS, avgI, avgR};
+    results.appendRow(row);
+    
+    // Hand the new state to the analytics thread
+    if (analytics) {
+        analytics->submit(step, timeVal, grid, cellBeta.data(), cellGamma.data());
+    }
+}
+
+RowBuffer GridSimulation::runSimulation(Arena& arena) {
+    // One pre-sized row per step: [time, avg_S, avg_I, avg_R]
+    RowBuffer results(arena, model.getNumSteps(), 4);
     
     for (int step = 0; step < model.getNumSteps(); ++step) {
-        // Update grid
-        updateGridNew();
-        
-        // Compute average S, I, R
-        double sumS = 0, sumI = 0, sumR = 0;
-        for (auto &cell : grid) {
-            sumS += cell.getS();
-            sumI += cell.getI();
-            sumR += cell.getR();
-        }
-        
-        double avgS = sumS / grid.size();
-        double avgI = sumI / grid.size();
-        double avgR = sumR / grid.size();
-        double timeVal = step * model.getDt();
-        
-        results.push_back({timeVal, avgS, avgI, avgR});
-        
-        // Synchronize processes
-        MPI_Barrier(MPI_COMM_WORLD);
+        advance(step, results);
     }
     
     return results;
-}
\ No newline at end of file
+}
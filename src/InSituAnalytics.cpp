@@ -0,0 +1,156 @@
+#include "../header/InSituAnalytics.h"
+#include <algorithm>
+#include <numeric>
+
+InSituAnalytics::InSituAnalytics(int poolSize)
+    : numCells(0), pool(std::max(1, poolSize)), stopping(false) {}
+
+InSituAnalytics::~InSituAnalytics() {
+    finish();
+}
+
+void InSituAnalytics::start(int localCells) {
+    numCells = localCells;
+    peakI.assign(numCells, 0.0);
+    peakTime.assign(numCells, 0.0);
+    finalReff.assign(numCells, 0.0);
+    reffBelowOneTime.assign(numCells, -1.0);
+    meanReff.clear();
+    stepTimes.clear();
+
+    // Size every snapshot once so submit never allocates
+    freeList.clear();
+    for (auto &snapshot : pool) {
+        snapshot.S.resize(numCells);
+        snapshot.I.resize(numCells);
+        snapshot.ratio.resize(numCells);
+        freeList.push_back(&snapshot);
+    }
+
+    stopping = false;
+    worker = std::thread(&InSituAnalytics::workerLoop, this);
+}
+
+void InSituAnalytics::submit(int step, double time, const std::vector<SIRCell>& grid,
+                             const double *cellBeta, const double *cellGamma) {
+    Snapshot *snapshot;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        bufferFree.wait(lock, [this] { return !freeList.empty(); });
+        snapshot = freeList.back();
+        freeList.pop_back();
+    }
+
+    // Copy outside the lock so the worker is never blocked by the simulation
+    snapshot->step = step;
+    snapshot->time = time;
+    int n = std::min(numCells, static_cast<int>(grid.size()));
+    for (int i = 0; i < n; ++i) {
+        snapshot->S[i] = grid[i].getS();
+        snapshot->I[i] = grid[i].getI();
+        snapshot->ratio[i] = cellGamma[i] > 0.0 ? cellBeta[i] / cellGamma[i] : 0.0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(snapshot);
+    }
+    queueReady.notify_one();
+}
+
+void InSituAnalytics::finish() {
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queueReady.notify_one();
+    worker.join();
+}
+
+void InSituAnalytics::workerLoop() {
+    while (true) {
+        Snapshot *snapshot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return; // Stopping and fully drained
+            }
+            snapshot = queue.front();
+            queue.pop_front();
+        }
+
+        process(*snapshot);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeList.push_back(snapshot);
+        }
+        bufferFree.notify_one();
+    }
+}
+
+void InSituAnalytics::process(const Snapshot &snapshot) {
+    double sumReff = 0.0;
+
+    for (int i = 0; i < numCells; ++i) {
+        // Peak detection on the infected fraction
+        if (snapshot.I[i] > peakI[i]) {
+            peakI[i] = snapshot.I[i];
+            peakTime[i] = snapshot.time;
+        }
+
+        // Effective reproduction number of the region
+        double reff = snapshot.ratio[i] * snapshot.S[i];
+        finalReff[i] = reff;
+        if (reff < 1.0 && reffBelowOneTime[i] < 0.0) {
+            reffBelowOneTime[i] = snapshot.time;
+        }
+        sumReff += reff;
+    }
+
+    meanReff.push_back(numCells > 0 ? sumReff / numCells : 0.0);
+    stepTimes.push_back(snapshot.time);
+}
+
+int InSituAnalytics::getNumCells() const {
+    return numCells;
+}
+
+const std::vector<double>& InSituAnalytics::getPeakI() const {
+    return peakI;
+}
+
+const std::vector<double>& InSituAnalytics::getPeakTime() const {
+    return peakTime;
+}
+
+const std::vector<double>& InSituAnalytics::getFinalReff() const {
+    return finalReff;
+}
+
+const std::vector<double>& InSituAnalytics::getReffBelowOneTime() const {
+    return reffBelowOneTime;
+}
+
+const std::vector<double>& InSituAnalytics::getMeanReff() const {
+    return meanReff;
+}
+
+const std::vector<double>& InSituAnalytics::getStepTimes() const {
+    return stepTimes;
+}
+
+std::vector<int> InSituAnalytics::topK(int k) const {
+    std::vector<int> order(numCells);
+    std::iota(order.begin(), order.end(), 0);
+    k = std::max(0, std::min(k, numCells));
+
+    std::partial_sort(order.begin(), order.begin() + k, order.end(),
+        [this](int a, int b) { return peakI[a] > peakI[b]; });
+    order.resize(k);
+    return order;
+}
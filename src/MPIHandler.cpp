@@ -1,16 +1,27 @@
 #include "../header/MPIHandler.h"
 #include "../header/CSVParser.h"
+#include "../header/TimeSeriesCodec.h"
 #include <mpi.h>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <sys/resource.h>
 
-MPIHandler::MPIHandler(int argc, char *argv[]) {
+MPIHandler::MPIHandler(int argc, char *argv[])
+    : localOffset(0), localRows(0), totalRows(0), topoComm(MPI_COMM_NULL),
+      haloRequest(MPI_REQUEST_NULL), haloPending(false) {
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 }
 
 MPIHandler::~MPIHandler() {
+    if (haloRequest != MPI_REQUEST_NULL) {
+        MPI_Request_free(&haloRequest);
+    }
+    if (topoComm != MPI_COMM_NULL) {
+        MPI_Comm_free(&topoComm);
+    }
     MPI_Finalize();
 }
 
@@ -22,19 +33,166 @@ int MPIHandler::getSize() const {
     return size; 
 }
 
-std::vector<SIRCell> MPIHandler::distributeData(const std::vector<std::vector<double>>& fullData) {
+void MPIHandler::barrier() {
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+int MPIHandler::getLocalOffset() const {
+    return localOffset;
+}
+
+int MPIHandler::ownerOf(int globalRow) const {
+    int rowsPerProc = totalRows / size;
+    int extra = totalRows % size;
+    int boundary = extra * (rowsPerProc + 1);
+    if (globalRow < boundary) {
+        return globalRow / (rowsPerProc + 1);
+    }
+    return extra + (globalRow - boundary) / rowsPerProc;
+}
+
+std::vector<int> MPIHandler::setupTopology(const std::unordered_map<int, std::vector<int>>& neighborMap) {
+    // Remote cells each owner must send us, sorted and without duplicates
+    std::vector<std::vector<int>> need(size);
+    for (int i = 0; i < localRows; i++) {
+        auto it = neighborMap.find(localOffset + i);
+        if (it == neighborMap.end()) continue;
+        for (int j : it->second) {
+            bool isLocal = j >= localOffset && j < localOffset + localRows;
+            if (j < 0 || j >= totalRows || isLocal) continue;
+            need[ownerOf(j)].push_back(j);
+        }
+    }
+    for (auto &ids : need) {
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+    
+    // One-time exchange of the request lists tells each rank what to send
+    std::vector<int> needCount(size), giveCount(size), needDispls(size), giveDispls(size);
+    std::vector<int> needFlat;
+    for (int proc = 0; proc < size; proc++) {
+        needCount[proc] = static_cast<int>(need[proc].size());
+        needDispls[proc] = static_cast<int>(needFlat.size());
+        needFlat.insert(needFlat.end(), need[proc].begin(), need[proc].end());
+    }
+    MPI_Alltoall(needCount.data(), 1, MPI_INT, giveCount.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    int giveTotal = 0;
+    for (int proc = 0; proc < size; proc++) {
+        giveDispls[proc] = giveTotal;
+        giveTotal += giveCount[proc];
+    }
+    std::vector<int> giveFlat(giveTotal);
+    MPI_Alltoallv(needFlat.data(), needCount.data(), needDispls.data(), MPI_INT,
+                  giveFlat.data(), giveCount.data(), giveDispls.data(), MPI_INT, MPI_COMM_WORLD);
+    
+    // Neighbor lists (weighted by cell count) and the per-neighbor layout
+    std::vector<int> sources, sourceWeights, dests, destWeights, haloIds;
+    sendCells.clear();
+    sendCounts.clear();
+    sendDispls.clear();
+    recvCounts.clear();
+    recvDispls.clear();
+    for (int proc = 0; proc < size; proc++) {
+        if (!need[proc].empty()) {
+            sources.push_back(proc);
+            sourceWeights.push_back(needCount[proc]);
+            recvDispls.push_back(3 * static_cast<int>(haloIds.size()));
+            recvCounts.push_back(3 * needCount[proc]);
+            haloIds.insert(haloIds.end(), need[proc].begin(), need[proc].end());
+        }
+        if (giveCount[proc] > 0) {
+            dests.push_back(proc);
+            destWeights.push_back(giveCount[proc]);
+            sendDispls.push_back(3 * static_cast<int>(sendCells.size()));
+            sendCounts.push_back(3 * giveCount[proc]);
+            for (int k = 0; k < giveCount[proc]; k++) {
+                sendCells.push_back(giveFlat[giveDispls[proc] + k] - localOffset);
+            }
+        }
+    }
+    sendBuffer.assign(3 * sendCells.size(), 0.0);
+    recvBuffer.assign(3 * haloIds.size(), 0.0);
+    
+    // Let MPI reorder ranks for locality; data ownership stays with the process
+    if (topoComm != MPI_COMM_NULL) {
+        MPI_Comm_free(&topoComm);
+    }
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,
+        static_cast<int>(sources.size()), sources.data(),
+        sources.empty() ? MPI_WEIGHTS_EMPTY : sourceWeights.data(),
+        static_cast<int>(dests.size()), dests.data(),
+        dests.empty() ? MPI_WEIGHTS_EMPTY : destWeights.data(),
+        MPI_INFO_NULL, 1, &topoComm);
+    
+#if MPI_VERSION >= 4
+    // Persistent neighborhood collective, restarted every step
+    if (haloRequest != MPI_REQUEST_NULL) {
+        MPI_Request_free(&haloRequest);
+    }
+    MPI_Neighbor_alltoallv_init(sendBuffer.data(), sendCounts.data(), sendDispls.data(), MPI_DOUBLE,
+                                recvBuffer.data(), recvCounts.data(), recvDispls.data(), MPI_DOUBLE,
+                                topoComm, MPI_INFO_NULL, &haloRequest);
+#endif
+    
+    std::cout << "Rank " << rank << " topology: receives " << haloIds.size() << " halo cells from "
+              << sources.size() << " ranks, sends " << sendCells.size() << " cells to "
+              << dests.size() << " ranks" << std::endl;
+    
+    return haloIds;
+}
+
+void MPIHandler::startHaloExchange(const std::vector<SIRCell>& grid) {
+    if (topoComm == MPI_COMM_NULL) {
+        return;
+    }
+    
+    for (size_t k = 0; k < sendCells.size(); k++) {
+        const SIRCell &cell = grid[sendCells[k]];
+        sendBuffer[3 * k] = cell.getS();
+        sendBuffer[3 * k + 1] = cell.getI();
+        sendBuffer[3 * k + 2] = cell.getR();
+    }
+    
+#if MPI_VERSION >= 4
+    MPI_Start(&haloRequest);
+#else
+    MPI_Ineighbor_alltoallv(sendBuffer.data(), sendCounts.data(), sendDispls.data(), MPI_DOUBLE,
+                            recvBuffer.data(), recvCounts.data(), recvDispls.data(), MPI_DOUBLE,
+                            topoComm, &haloRequest);
+#endif
+    haloPending = true;
+}
+
+void MPIHandler::finishHaloExchange(std::vector<SIRCell>& halo) {
+    if (!haloPending) {
+        return;
+    }
+    MPI_Wait(&haloRequest, MPI_STATUS_IGNORE);
+    haloPending = false;
+    
+    // Setters copy the received values as-is (the constructor would renormalize)
+    size_t count = std::min(halo.size(), recvBuffer.size() / 3);
+    for (size_t k = 0; k < count; k++) {
+        halo[k].setS(recvBuffer[3 * k]);
+        halo[k].setI(recvBuffer[3 * k + 1]);
+        halo[k].setR(recvBuffer[3 * k + 2]);
+    }
+}
+
+std::vector<SIRCell> MPIHandler::distributeData(const RowBuffer& fullData, Arena& arena) {
     std::vector<SIRCell> localGrid;
     
     // Debug: Print data size on each rank
     if (rank == 0) {
-        std::cout << "Rank 0 has full data with " << fullData.size() << " rows" << std::endl;
+        std::cout << "Rank 0 has full data with " << fullData.getRows() << " rows" << std::endl;
     } else {
         std::cout << "Rank " << rank << " initially has 0 rows (no data)" << std::endl;
     }
     
     int totalRows = 0;
     if (rank == 0) {
-        totalRows = static_cast<int>(fullData.size());
+        totalRows = static_cast<int>(fullData.getRows());
     }
     MPI_Bcast(&totalRows, 1, MPI_INT, 0, MPI_COMM_WORLD);
     
@@ -53,40 +211,49 @@ std::vector<SIRCell> MPIHandler::distributeData(const std::vector<std::vector<do
         startIndex = rank * localRows + extra;
     }
     
+    localOffset = startIndex;
+    this->localRows = localRows;
+    this->totalRows = totalRows;
+    
     // Debug: Show assigned ranges
     std::cout << "Rank " << rank << " is assigned rows " << startIndex << " to " 
               << (startIndex + localRows - 1) << " (" << localRows << " rows)" << std::endl;
     
     MPI_Barrier(MPI_COMM_WORLD);
     
+    localGrid.reserve(localRows);
+    
     if (rank == 0) {
         // Process 0 handles its own portion
-        for (int i = startIndex; i < startIndex + localRows && i < static_cast<int>(fullData.size()); i++) {
-            localGrid.push_back(CSVParser::mapToSIR(fullData[i]));
+        for (int i = startIndex; i < startIndex + localRows && i < static_cast<int>(fullData.getRows()); i++) {
+            localGrid.push_back(CSVParser::mapToSIR(fullData.row(i)));
         }
         
         // Debug: Confirm rank 0's own data assignment
         std::cout << "Rank 0 kept " << localGrid.size() << " rows for itself" << std::endl;
         
+        // One send region sized for the largest portion, reused for every process
+        double *sendBuffer = arena.allocate<double>((rowsPerProc + 1) * 3);
+        
         // Send portions to other processes
         for (int proc = 1; proc < size; proc++) {
             int procRows = (proc < extra) ? rowsPerProc + 1 : rowsPerProc;
             int procStart = (proc < extra) ? proc * (rowsPerProc + 1) : proc * rowsPerProc + extra;
-            std::vector<double> sendBuffer;
+            int sendCount = 0;
             
-            for (int i = procStart; i < procStart + procRows && i < static_cast<int>(fullData.size()); i++) {
-                SIRCell cell = CSVParser::mapToSIR(fullData[i]);
-                sendBuffer.push_back(cell.getS());
-                sendBuffer.push_back(cell.getI());
-                sendBuffer.push_back(cell.getR());
+            for (int i = procStart; i < procStart + procRows && i < static_cast<int>(fullData.getRows()); i++) {
+                SIRCell cell = CSVParser::mapToSIR(fullData.row(i));
+                sendBuffer[sendCount++] = cell.getS();
+                sendBuffer[sendCount++] = cell.getI();
+                sendBuffer[sendCount++] = cell.getR();
             }
             
             // Debug: Show what's being sent
-            std::cout << "Rank 0 sending " << sendBuffer.size()/3 << " rows to rank " << proc << std::endl;
+            std::cout << "Rank 0 sending " << sendCount/3 << " rows to rank " << proc << std::endl;
             
             // Send the data
-            if (!sendBuffer.empty()) {
-                MPI_Send(sendBuffer.data(), sendBuffer.size(), MPI_DOUBLE, proc, 0, MPI_COMM_WORLD);
+            if (sendCount > 0) {
+                MPI_Send(sendBuffer, sendCount, MPI_DOUBLE, proc, 0, MPI_COMM_WORLD);
             } else {
                 // Send empty signal
                 double dummy = -1.0;
@@ -95,10 +262,11 @@ std::vector<SIRCell> MPIHandler::distributeData(const std::vector<std::vector<do
             }
         }
     } else {
-        // Other processes receive their portion
-        std::vector<double> recvBuffer(localRows * 3);
+        // Other processes receive their portion (room for at least the empty signal)
+        int recvCapacity = std::max(localRows * 3, 1);
+        double *recvBuffer = arena.allocate<double>(recvCapacity);
         MPI_Status status;
-        MPI_Recv(recvBuffer.data(), localRows * 3, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, &status);
+        MPI_Recv(recvBuffer, recvCapacity, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, &status);
         
         // Debug: Check how much data was actually received
         int count;
@@ -129,49 +297,242 @@ std::vector<SIRCell> MPIHandler::distributeData(const std::vector<std::vector<do
     
     if (rank == 0) {
         std::cout << "Total distributed rows: " << totalSize 
-                  << " (original size: " << fullData.size() << ")" << std::endl;
+                  << " (original size: " << fullData.getRows() << ")" << std::endl;
     }
     
     return localGrid;
 }
 
-std::vector<double> MPIHandler::gatherResults(const std::vector<std::vector<double>>& localResults) {
-    int steps = static_cast<int>(localResults.size());
-    std::vector<double> localFlat;
+void MPIHandler::broadcastRows(RowBuffer& rows, Arena& arena) {
+    long shape[2] = {0, 0};
+    if (rank == 0) {
+        shape[0] = static_cast<long>(rows.getRows());
+        shape[1] = static_cast<long>(rows.getCols());
+    }
+    MPI_Bcast(shape, 2, MPI_LONG, 0, MPI_COMM_WORLD);
     
-    for (auto &row : localResults) {
-        localFlat.insert(localFlat.end(), row.begin(), row.end());
+    if (rank != 0) {
+        rows = RowBuffer(arena, shape[0], shape[1]);
+        rows.resize(shape[0]);
     }
+    MPI_Bcast(rows.data(), static_cast<int>(shape[0] * shape[1]), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+}
+
+CalibrationResult MPIHandler::selectBestCalibration(const CalibrationResult& local) {
+    struct {
+        double error;
+        int rank;
+    } mine = {local.error, rank}, best;
+    MPI_Allreduce(&mine, &best, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
     
-    std::vector<double> globalFlat;
+    // The winning rank shares its parameters with everyone
+    double packed[5] = {local.beta, local.gamma, local.error,
+                        static_cast<double>(local.iterations), static_cast<double>(local.evaluations)};
+    MPI_Bcast(packed, 5, MPI_DOUBLE, best.rank, MPI_COMM_WORLD);
+    
+    // Report the total work done by all ranks
+    int totalEvaluations = 0;
+    MPI_Allreduce(&local.evaluations, &totalEvaluations, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    
+    return CalibrationResult{packed[0], packed[1], packed[2],
+                             static_cast<int>(packed[3]), totalEvaluations};
+}
+
+RowBuffer MPIHandler::gatherResults(const RowBuffer& localResults, Arena& arena) {
+    int steps = static_cast<int>(localResults.getRows());
+    int cols = static_cast<int>(localResults.getCols());
+    
+    // Local results are already flat, so they can be gathered in place
+    RowBuffer globalResults;
     if (rank == 0) {
-        globalFlat.resize(steps * 4 * size);
+        globalResults = RowBuffer(arena, steps * size, cols);
+        globalResults.resize(steps * size);
     }
     
-    MPI_Gather(localFlat.data(), steps * 4, MPI_DOUBLE,
-               globalFlat.data(), steps * 4, MPI_DOUBLE,
+    MPI_Gather(localResults.data(), steps * cols, MPI_DOUBLE,
+               globalResults.data(), steps * cols, MPI_DOUBLE,
                0, MPI_COMM_WORLD);
     
-    return globalFlat;
+    return globalResults;
 }
 
-void MPIHandler::writeResults(const std::vector<double>& globalFlat, int steps) {
+void MPIHandler::writeResults(const RowBuffer& globalResults, int steps) {
     if (rank == 0) {
         std::ofstream outfile("simulation_results.csv");
         outfile << "Process,Time,S,I,R\n";
         
         for (int proc = 0; proc < size; proc++) {
             for (int i = 0; i < steps; i++) {
-                int index = (proc * steps + i) * 4;
+                const double *row = globalResults.row(proc * steps + i);
                 outfile << proc << "," 
-                        << globalFlat[index] << ","
-                        << globalFlat[index+1] << ","
-                        << globalFlat[index+2] << ","
-                        << globalFlat[index+3] << "\n";
+                        << row[0] << ","
+                        << row[1] << ","
+                        << row[2] << ","
+                        << row[3] << "\n";
             }
         }
         
         outfile.close();
         std::cout << "Results written to simulation_results.csv" << std::endl;
     }
-}
\ No newline at end of file
+}
+
+void MPIHandler::writeCompressedResults(const RowBuffer& globalResults, int steps, double maxError) {
+    if (rank != 0) {
+        return;
+    }
+    
+    // Same table as the CSV output, stored column by column
+    std::vector<TimeSeriesCodec::Column> columns(5);
+    const char *names[5] = {"Process", "Time", "S", "I", "R"};
+    for (int c = 0; c < 5; c++) {
+        columns[c].name = names[c];
+        columns[c].values.reserve(size * steps);
+    }
+    columns[0].quantizable = false;
+    columns[1].quantizable = false;
+    
+    for (int proc = 0; proc < size; proc++) {
+        for (int i = 0; i < steps; i++) {
+            const double *row = globalResults.row(proc * steps + i);
+            columns[0].values.push_back(proc);
+            for (int c = 0; c < 4; c++) {
+                columns[c + 1].values.push_back(row[c]);
+            }
+        }
+    }
+    
+    TimeSeriesCodec::writeFile("simulation_results.sirz", columns, maxError);
+    std::cout << "Results written to simulation_results.sirz ("
+              << (maxError > 0.0 ? "quantized" : "lossless") << ")" << std::endl;
+}
+
+void MPIHandler::writeAnalytics(const InSituAnalytics& analytics, int topK, bool writeCells) {
+    // Region summary: [region, peakTime, peakI, finalReff, reffBelowOneTime]
+    const int fields = 5;
+    int localCells = analytics.getNumCells();
+    auto packRegion = [&](int i, double *out) {
+        out[0] = localOffset + i; // Regions are numbered by their global row
+        out[1] = analytics.getPeakTime()[i];
+        out[2] = analytics.getPeakI()[i];
+        out[3] = analytics.getFinalReff()[i];
+        out[4] = analytics.getReffBelowOneTime()[i];
+    };
+    
+    // Each rank offers its own top-k; unused slots carry region -1
+    int k = std::max(0, topK);
+    std::vector<double> localTop(k * fields, -1.0);
+    std::vector<int> localBest = analytics.topK(k);
+    for (size_t j = 0; j < localBest.size(); j++) {
+        packRegion(localBest[j], &localTop[fields * j]);
+    }
+    std::vector<double> candidates(rank == 0 ? size * k * fields : 0);
+    MPI_Gather(localTop.data(), k * fields, MPI_DOUBLE,
+               candidates.data(), k * fields, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    
+    // Cell-weighted mean R_eff per step across all ranks
+    int steps = static_cast<int>(analytics.getMeanReff().size());
+    std::vector<double> localReffSum(steps);
+    for (int s = 0; s < steps; s++) {
+        localReffSum[s] = analytics.getMeanReff()[s] * localCells;
+    }
+    std::vector<double> reffSum(rank == 0 ? steps : 0);
+    long localCount = localCells, totalCells = 0;
+    MPI_Reduce(localReffSum.data(), reffSum.data(), steps, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&localCount, &totalCells, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    
+    // Optional full per-region table, streamed to rank 0 one rank at a time
+    if (writeCells) {
+        std::vector<double> block(localCells * fields);
+        for (int i = 0; i < localCells; i++) {
+            packRegion(i, &block[fields * i]);
+        }
+        if (rank == 0) {
+            std::ofstream cellfile("analytics_cells.csv");
+            cellfile << "Region,PeakTime,PeakI,FinalReff,ReffBelowOneTime\n";
+            for (int proc = 0; proc < size; proc++) {
+                if (proc > 0) {
+                    int count;
+                    MPI_Status status;
+                    MPI_Probe(proc, 1, MPI_COMM_WORLD, &status);
+                    MPI_Get_count(&status, MPI_DOUBLE, &count);
+                    block.resize(count);
+                    MPI_Recv(block.data(), count, MPI_DOUBLE, proc, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                }
+                for (size_t r = 0; r + fields <= block.size(); r += fields) {
+                    cellfile << static_cast<long>(block[r]) << "," << block[r + 1] << ","
+                             << block[r + 2] << "," << block[r + 3] << "," << block[r + 4] << "\n";
+                }
+            }
+            std::cout << "Per-region analytics written to analytics_cells.csv" << std::endl;
+        } else {
+            MPI_Send(block.data(), static_cast<int>(block.size()), MPI_DOUBLE, 0, 1, MPI_COMM_WORLD);
+        }
+    }
+    
+    if (rank != 0) {
+        return;
+    }
+    
+    // Time at which the mean R_eff first drops below 1
+    double reffBelowOne = -1.0;
+    for (int s = 0; s < steps && totalCells > 0; s++) {
+        if (reffSum[s] / totalCells < 1.0) {
+            reffBelowOne = analytics.getStepTimes()[s];
+            std::cout << "Mean R_eff drops below 1 at time " << reffBelowOne << std::endl;
+            break;
+        }
+    }
+    
+    // Reduce the size * k candidates to the global top-k
+    std::vector<int> order;
+    for (int c = 0; c < size * k; c++) {
+        if (candidates[fields * c] >= 0.0) {
+            order.push_back(c);
+        }
+    }
+    int best = std::min(k, static_cast<int>(order.size()));
+    std::partial_sort(order.begin(), order.begin() + best, order.end(),
+        [&](int a, int b) { return candidates[fields * a + 2] > candidates[fields * b + 2]; });
+    
+    std::ofstream outfile("analytics_summary.csv");
+    outfile << "Rank,Region,PeakTime,PeakI,FinalReff,ReffBelowOneTime,MeanReffBelowOneTime\n";
+    std::cout << "Top " << best << " regions by infection peak:" << std::endl;
+    for (int j = 0; j < best; j++) {
+        const double *c = &candidates[fields * order[j]];
+        outfile << j + 1 << "," << static_cast<long>(c[0]) << "," << c[1] << "," << c[2] << ","
+                << c[3] << "," << c[4] << "," << reffBelowOne << "\n";
+        std::cout << "  Region " << static_cast<long>(c[0]) << ": peak I " << c[2]
+                  << " at time " << c[1] << std::endl;
+    }
+    outfile.close();
+    std::cout << "Analytics summary written to analytics_summary.csv" << std::endl;
+}
+
+void MPIHandler::reportMemoryUsage(const Arena& arena) {
+    // Process high-water mark as reported by the OS (kilobytes on Linux)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    
+    double local[3] = {
+        static_cast<double>(arena.getPeak()),
+        static_cast<double>(arena.getReserved()),
+        static_cast<double>(usage.ru_maxrss) * 1024.0
+    };
+    
+    std::vector<double> all;
+    if (rank == 0) {
+        all.resize(3 * size);
+    }
+    MPI_Gather(local, 3, MPI_DOUBLE, all.data(), 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    
+    if (rank == 0) {
+        const double MiB = 1024.0 * 1024.0;
+        for (int proc = 0; proc < size; proc++) {
+            std::cout << "Rank " << proc << " memory: arena peak "
+                      << all[3 * proc] / MiB << " MiB, arena reserved "
+                      << all[3 * proc + 1] / MiB << " MiB, process peak RSS "
+                      << all[3 * proc + 2] / MiB << " MiB" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,173 @@
+#include "../header/ParameterSchedule.h"
+#include <algorithm>
+#include <stdexcept>
+
+ParameterSchedule::ParameterSchedule(double baseBeta, double baseGamma)
+    : baseRate{baseBeta, baseGamma}, numGroups(0), tables(2), nextEvent(0) {
+    ensureGroup(0);
+}
+
+void ParameterSchedule::ensureGroup(int group) {
+    if (group < numGroups) {
+        return;
+    }
+    numGroups = group + 1;
+    tables.resize(2 * (numGroups + 1));
+    overrideValue.resize(2 * numGroups, 0.0);
+    hasOverride.resize(2 * numGroups, false);
+    scale.resize(2 * numGroups, 1.0);
+
+    // New groups start at the base rates until the next advanceTo
+    while (static_cast<int>(groupRate.size()) < 2 * numGroups) {
+        groupRate.push_back(baseRate[groupRate.size() % 2]);
+    }
+}
+
+void ParameterSchedule::checkTarget(int group, int parameter) const {
+    if (group < ALL_GROUPS) {
+        throw std::invalid_argument("group must be * or non-negative");
+    }
+    if (parameter != BETA && parameter != GAMMA) {
+        throw std::invalid_argument("unknown parameter");
+    }
+}
+
+void ParameterSchedule::setCellGroup(int cell, int group) {
+    if (cell < 0 || group < 0) {
+        throw std::invalid_argument("cell and group must be non-negative");
+    }
+    ensureGroup(group);
+    if (cell >= static_cast<int>(cellGroup.size())) {
+        cellGroup.resize(cell + 1, 0);
+    }
+    cellGroup[cell] = group;
+}
+
+void ParameterSchedule::addKnot(int group, int parameter, double time, double value, bool linear) {
+    checkTarget(group, parameter);
+    if (group != ALL_GROUPS) {
+        ensureGroup(group);
+    }
+    Table &table = tables[2 * (group + 1) + parameter];
+
+    // One interpolation mode per table
+    if (!table.time.empty() && table.linear != linear) {
+        throw std::invalid_argument("knot mode differs from earlier knots of the same table");
+    }
+
+    // Keep knots sorted by time
+    auto pos = std::upper_bound(table.time.begin(), table.time.end(), time);
+    size_t index = pos - table.time.begin();
+    table.time.insert(pos, time);
+    table.value.insert(table.value.begin() + index, value);
+    table.linear = linear;
+    table.cursor = 0;
+}
+
+void ParameterSchedule::scheduleEvent(int step, int group, int parameter, int op, double value) {
+    checkTarget(group, parameter);
+    if (group != ALL_GROUPS) {
+        ensureGroup(group);
+    }
+
+    // Insert after every event of the same step to keep insertion order
+    auto pos = std::upper_bound(events.begin(), events.end(), step,
+        [](int s, const Event& event) { return s < event.step; });
+    events.insert(pos, Event{step, group, parameter, op, value});
+}
+
+double ParameterSchedule::evaluateTable(Table& table, double time, double before) {
+    size_t n = table.time.size();
+    if (n == 0 || time < table.time[0]) {
+        return before;
+    }
+
+    // Time normally only moves forward, so the cursor makes lookups O(1)
+    if (table.cursor >= n || time < table.time[table.cursor]) {
+        table.cursor = 0;
+    }
+    while (table.cursor + 1 < n && time >= table.time[table.cursor + 1]) {
+        table.cursor++;
+    }
+
+    size_t k = table.cursor;
+    if (!table.linear || k + 1 >= n || time <= table.time[k]) {
+        return table.value[k];
+    }
+    double t = (time - table.time[k]) / (table.time[k + 1] - table.time[k]);
+    return table.value[k] + t * (table.value[k + 1] - table.value[k]);
+}
+
+void ParameterSchedule::applyEvent(const Event& event, int group) {
+    int index = 2 * group + event.parameter;
+    if (event.op == SET) {
+        overrideValue[index] = event.value;
+        hasOverride[index] = true;
+    } else if (event.op == SCALE) {
+        scale[index] *= event.value;
+    } else {
+        hasOverride[index] = false;
+        scale[index] = 1.0;
+    }
+}
+
+void ParameterSchedule::advanceTo(int step, double time) {
+    // Apply every event due at or before this step boundary
+    for (; nextEvent < events.size() && events[nextEvent].step <= step; ++nextEvent) {
+        const Event &event = events[nextEvent];
+        if (event.group == ALL_GROUPS) {
+            for (int g = 0; g < numGroups; ++g) {
+                applyEvent(event, g);
+            }
+        } else {
+            applyEvent(event, event.group);
+        }
+    }
+
+    // Shared defaults are evaluated once, then each group resolves its own rates
+    double defaultRate[2];
+    for (int p = 0; p < 2; ++p) {
+        defaultRate[p] = evaluateTable(tables[p], time, baseRate[p]);
+    }
+    for (int g = 0; g < numGroups; ++g) {
+        for (int p = 0; p < 2; ++p) {
+            int index = 2 * g + p;
+            Table &own = tables[2 * (g + 1) + p];
+            double value = evaluateTable(own, time, defaultRate[p]);
+            if (hasOverride[index]) {
+                value = overrideValue[index];
+            }
+            groupRate[index] = value * scale[index];
+        }
+    }
+}
+
+void ParameterSchedule::rewind() {
+    nextEvent = 0;
+    std::fill(hasOverride.begin(), hasOverride.end(), false);
+    std::fill(scale.begin(), scale.end(), 1.0);
+    for (auto &table : tables) {
+        table.cursor = 0;
+    }
+    for (size_t index = 0; index < groupRate.size(); ++index) {
+        groupRate[index] = baseRate[index % 2];
+    }
+}
+
+void ParameterSchedule::fillCellRates(int offset, int count, double *beta, double *gamma) const {
+    int mapped = static_cast<int>(cellGroup.size());
+    for (int i = 0; i < count; ++i) {
+        int cell = offset + i;
+        int group = cell < mapped ? cellGroup[cell] : 0;
+        beta[i] = groupRate[2 * group];
+        gamma[i] = groupRate[2 * group + 1];
+    }
+}
+
+int ParameterSchedule::getNumGroups() const {
+    return numGroups;
+}
+
+double ParameterSchedule::getGroupRate(int group, int parameter) const {
+    return groupRate[2 * group + parameter];
+}
@@ -63,6 +63,11 @@ SIRCell SIRModel::rk4Step(const SIRCell &current) const {
 }
 
 SIRCell SIRModel::rk4StepWithNeighbors(const SIRCell& current, const std::vector<SIRCell>& neighbors) const {
+    return rk4StepWithNeighbors(current, neighbors, beta, gammaRate);
+}
+
+SIRCell SIRModel::rk4StepWithNeighbors(const SIRCell& current, const std::vector<SIRCell>& neighbors,
+                                       double cellBeta, double cellGamma) const {
     double S = current.getS();
     double I = current.getI();
     double R = current.getR();
@@ -77,13 +82,13 @@ SIRCell SIRModel::rk4StepWithNeighbors(const SIRCell& current, const std::vector
 
     // Modified equations using avgI from neighbors
     auto fS = [&](double s) -> double {
-        return -beta * s * avgI;
+        return -cellBeta * s * avgI;
     };
     auto fI = [&](double s, double i) -> double {
-        return beta * s * avgI - gammaRate * i;
+        return cellBeta * s * avgI - cellGamma * i;
     };
     auto fR = [&](double i) -> double {
-        return gammaRate * i;
+        return cellGamma * i;
     };
 
     // RK4 method
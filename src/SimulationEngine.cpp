@@ -0,0 +1,85 @@
+#include "../header/SimulationEngine.h"
+
+SimulationEngine::SimulationEngine(const SIRModel& m)
+    : model(m), simulation(m, serial), currentStep(0) {
+    results = RowBuffer(arena, model.getNumSteps(), 4);
+}
+
+SimulationEngine::SimulationEngine(const SIRModel& m, Communicator& comm)
+    : model(m), simulation(m, comm), currentStep(0) {
+    results = RowBuffer(arena, model.getNumSteps(), 4);
+}
+
+void SimulationEngine::setCells(const double *S, const double *I, const double *R, int numCells) {
+    std::vector<SIRCell> cells;
+    cells.reserve(numCells);
+    for (int i = 0; i < numCells; ++i) {
+        cells.emplace_back(S[i], I[i], R[i]);
+    }
+    setCells(cells);
+}
+
+void SimulationEngine::setCells(const std::vector<SIRCell>& cells) {
+    simulation.setGrid(cells);
+
+    // Start a fresh run, reusing the arena's memory for the result buffer
+    arena.reset();
+    results = RowBuffer(arena, model.getNumSteps(), 4);
+    currentStep = 0;
+}
+
+void SimulationEngine::setRates(double beta, double gamma) {
+    model = SIRModel(beta, gamma, model.getDt(), model.getNumSteps());
+    simulation.setRates(beta, gamma);
+}
+
+void SimulationEngine::setNeighbors(const int *offsets, const int *neighbors, int numCells) {
+    std::unordered_map<int, std::vector<int>> map;
+    for (int c = 0; c < numCells; ++c) {
+        map[c].assign(neighbors + offsets[c], neighbors + offsets[c + 1]);
+    }
+    simulation.setNeighborMap(map);
+}
+
+void SimulationEngine::setNeighborMap(const std::unordered_map<int, std::vector<int>>& map) {
+    simulation.setNeighborMap(map);
+}
+
+bool SimulationEngine::step() {
+    if (currentStep >= model.getNumSteps()) {
+        return false;
+    }
+    simulation.advance(currentStep, results);
+    currentStep++;
+    return true;
+}
+
+const RowBuffer& SimulationEngine::run() {
+    while (step()) {
+    }
+    return results;
+}
+
+const SIRCell *SimulationEngine::getCells() const {
+    return simulation.getGrid().data();
+}
+
+int SimulationEngine::getNumCells() const {
+    return simulation.getLocalSize();
+}
+
+const RowBuffer& SimulationEngine::getResults() const {
+    return results;
+}
+
+int SimulationEngine::getCurrentStep() const {
+    return currentStep;
+}
+
+const SIRModel& SimulationEngine::getModel() const {
+    return model;
+}
+
+GridSimulation& SimulationEngine::getSimulation() {
+    return simulation;
+}
@@ -0,0 +1,353 @@
+#include "../header/TimeSeriesCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = {'S', 'I', 'R', 'Z'};
+const uint8_t VERSION = 1;
+
+uint64_t toBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Byte-level helpers for the container
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putDouble(std::vector<uint8_t>& out, double value) {
+    uint64_t bits = toBits(value);
+    for (int b = 0; b < 8; ++b) {
+        out.push_back(static_cast<uint8_t>(bits >> (8 * b)));
+    }
+}
+
+class ByteReader {
+private:
+    const std::vector<uint8_t>& bytes;
+    size_t pos;
+
+public:
+    explicit ByteReader(const std::vector<uint8_t>& data) : bytes(data), pos(0) {}
+
+    uint8_t byte() {
+        if (pos >= bytes.size()) {
+            throw std::runtime_error("Truncated time series data");
+        }
+        return bytes[pos++];
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Malformed varint in time series data");
+    }
+
+    double real() {
+        uint64_t bits = 0;
+        for (int b = 0; b < 8; ++b) {
+            bits |= static_cast<uint64_t>(byte()) << (8 * b);
+        }
+        return fromBits(bits);
+    }
+
+    size_t position() const { return pos; }
+    void skip(size_t n) { pos += n; }
+};
+
+// Bit-level helpers for the Gorilla stream
+class BitWriter {
+private:
+    std::vector<uint8_t>& out;
+    int used; // Bits used in the last byte
+
+public:
+    explicit BitWriter(std::vector<uint8_t>& buffer) : out(buffer), used(8) {}
+
+    void write(uint64_t value, int bits) {
+        for (int b = bits - 1; b >= 0; --b) {
+            if (used == 8) {
+                out.push_back(0);
+                used = 0;
+            }
+            if ((value >> b) & 1) {
+                out.back() |= static_cast<uint8_t>(0x80 >> used);
+            }
+            used++;
+        }
+    }
+};
+
+class BitReader {
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t bit;
+
+public:
+    BitReader(const uint8_t *bytes, size_t length) : data(bytes), size(length), bit(0) {}
+
+    uint64_t read(int bits) {
+        uint64_t value = 0;
+        for (int b = 0; b < bits; ++b, ++bit) {
+            if (bit / 8 >= size) {
+                throw std::runtime_error("Truncated Gorilla stream");
+            }
+            value = (value << 1) | ((data[bit / 8] >> (7 - bit % 8)) & 1);
+        }
+        return value;
+    }
+};
+
+int leadingZeros(uint64_t x) {
+    int n = 0;
+    for (uint64_t mask = 1ULL << 63; mask && !(x & mask); mask >>= 1) {
+        n++;
+    }
+    return n;
+}
+
+int trailingZeros(uint64_t x) {
+    int n = 0;
+    for (uint64_t mask = 1; mask && !(x & mask); mask <<= 1) {
+        n++;
+    }
+    return n;
+}
+
+void encodeGorilla(const std::vector<double>& values, std::vector<uint8_t>& out) {
+    if (values.empty()) {
+        return;
+    }
+    BitWriter writer(out);
+    uint64_t prev = toBits(values[0]);
+    writer.write(prev, 64);
+
+    int prevLeading = -1, prevTrailing = 0;
+    for (size_t i = 1; i < values.size(); ++i) {
+        uint64_t bits = toBits(values[i]);
+        uint64_t x = bits ^ prev;
+        prev = bits;
+
+        // Identical value: a single zero bit
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        writer.write(1, 1);
+
+        int leading = std::min(leadingZeros(x), 31);
+        int trailing = trailingZeros(x);
+        if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing) {
+            // Meaningful bits fit the previous window
+            writer.write(0, 1);
+            writer.write(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+        } else {
+            int significant = 64 - leading - trailing;
+            writer.write(1, 1);
+            writer.write(leading, 5);
+            writer.write(significant - 1, 6);
+            writer.write(x >> trailing, significant);
+            prevLeading = leading;
+            prevTrailing = trailing;
+        }
+    }
+}
+
+void decodeGorilla(const uint8_t *data, size_t length, size_t rows, std::vector<double>& values) {
+    values.clear();
+    if (rows == 0) {
+        return;
+    }
+    BitReader reader(data, length);
+    uint64_t prev = reader.read(64);
+    values.push_back(fromBits(prev));
+
+    int prevLeading = 0, prevTrailing = 0;
+    for (size_t i = 1; i < rows; ++i) {
+        if (reader.read(1)) {
+            if (reader.read(1)) {
+                prevLeading = static_cast<int>(reader.read(5));
+                int significant = static_cast<int>(reader.read(6)) + 1;
+                prevTrailing = 64 - prevLeading - significant;
+            }
+            int significant = 64 - prevLeading - prevTrailing;
+            prev ^= reader.read(significant) << prevTrailing;
+        }
+        values.push_back(fromBits(prev));
+    }
+}
+
+// Quantized columns need every value representable as a 63-bit integer multiple of
+// the step, and its reconstruction (computed exactly as the decoder does) within
+// maxError; near the spacing of doubles rounding alone can exceed the bound
+bool canQuantize(const std::vector<double>& values, double step, double maxError) {
+    const double limit = std::ldexp(1.0, 62);
+    for (double v : values) {
+        if (!std::isfinite(v) || std::fabs(v / step) >= limit) {
+            return false;
+        }
+        if (std::fabs(std::llround(v / step) * step - v) > maxError) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void encodeQuantized(const std::vector<double>& values, double step, std::vector<uint8_t>& out) {
+    int64_t prev = 0;
+    for (double v : values) {
+        int64_t q = std::llround(v / step);
+        int64_t delta = q - prev;
+        prev = q;
+        putVarint(out, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+    }
+}
+
+void decodeQuantized(ByteReader& reader, size_t rows, double step, std::vector<double>& values) {
+    values.clear();
+    int64_t prev = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        uint64_t zigzag = reader.varint();
+        int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        prev += delta;
+        values.push_back(prev * step);
+    }
+}
+
+} // namespace
+
+std::vector<uint8_t> TimeSeriesCodec::encode(const std::vector<Column>& columns, double maxError) {
+    std::vector<uint8_t> out(MAGIC, MAGIC + 4);
+    out.push_back(VERSION);
+    putVarint(out, columns.size());
+
+    // Rounding to a grid of 2 * maxError keeps every error within maxError
+    double step = 2.0 * maxError;
+    std::vector<uint8_t> payload;
+
+    for (const auto &column : columns) {
+        putVarint(out, column.name.size());
+        out.insert(out.end(), column.name.begin(), column.name.end());
+
+        bool quantize = maxError > 0.0 && column.quantizable && canQuantize(column.values, step, maxError);
+        out.push_back(quantize ? QUANTIZED : GORILLA);
+        putVarint(out, column.values.size());
+
+        payload.clear();
+        if (quantize) {
+            putDouble(out, step);
+            encodeQuantized(column.values, step, payload);
+        } else {
+            encodeGorilla(column.values, payload);
+        }
+        putVarint(out, payload.size());
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+    return out;
+}
+
+std::vector<TimeSeriesCodec::Column> TimeSeriesCodec::decode(const std::vector<uint8_t>& bytes) {
+    if (bytes.size() < 5 || std::memcmp(bytes.data(), MAGIC, 4) != 0) {
+        throw std::runtime_error("Not a compressed time series file");
+    }
+    ByteReader reader(bytes);
+    reader.skip(4);
+    if (reader.byte() != VERSION) {
+        throw std::runtime_error("Unsupported time series format version");
+    }
+
+    std::vector<Column> columns(reader.varint());
+    for (auto &column : columns) {
+        size_t nameLength = reader.varint();
+        for (size_t k = 0; k < nameLength; ++k) {
+            column.name.push_back(static_cast<char>(reader.byte()));
+        }
+
+        uint8_t encoding = reader.byte();
+        column.quantizable = encoding == QUANTIZED;
+        size_t rows = reader.varint();
+        double step = encoding == QUANTIZED ? reader.real() : 0.0;
+        size_t payloadLength = reader.varint();
+        size_t start = reader.position();
+        if (start + payloadLength > bytes.size()) {
+            throw std::runtime_error("Truncated time series data");
+        }
+
+        if (encoding == QUANTIZED) {
+            decodeQuantized(reader, rows, step, column.values);
+        } else if (encoding == GORILLA) {
+            decodeGorilla(bytes.data() + start, payloadLength, rows, column.values);
+        } else {
+            throw std::runtime_error("Unknown column encoding");
+        }
+
+        // Continue after the payload regardless of how much the decoder consumed
+        if (reader.position() > start + payloadLength) {
+            throw std::runtime_error("Corrupt column payload");
+        }
+        reader.skip(start + payloadLength - reader.position());
+    }
+    return columns;
+}
+
+void TimeSeriesCodec::writeFile(const std::string& filename, const std::vector<Column>& columns, double maxError) {
+    std::vector<uint8_t> bytes = encode(columns, maxError);
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile) {
+        throw std::runtime_error("Error opening file " + filename);
+    }
+    outfile.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+std::vector<TimeSeriesCodec::Column> TimeSeriesCodec::readFile(const std::string& filename) {
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile) {
+        throw std::runtime_error("Error opening file " + filename);
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+    return decode(bytes);
+}
+
+void TimeSeriesCodec::writeCSV(const std::vector<Column>& columns, std::ostream& out) {
+    size_t rows = 0;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        out << (c ? "," : "") << columns[c].name;
+        rows = std::max(rows, columns[c].values.size());
+    }
+    out << "\n";
+
+    out.precision(std::numeric_limits<double>::max_digits10);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (c) out << ",";
+            if (r < columns[c].values.size()) out << columns[c].values[r];
+        }
+        out << "\n";
+    }
+}